@@ -3,9 +3,29 @@
 /// David Lafreniere, 2024.
 
 #include "serialize.h"
+#include "serialize_stats.h"
+#include "serialize_transcode.h"
+#include "serialize_columnar.h"
+#include "serialize_schema.h"
+#include "serialize_upgrade.h"
+#include "serialize_hash.h"
+#include "serialize_diff.h"
+#include "serialize_bus.h"
+#include "serialize_batch.h"
+#include "serialize_coalesce.h"
+#include "serialize_flow.h"
+#include "serialize_scheduler.h"
+#include "serialize_fragment.h"
+#include "serialize_frame.h"
+#include "serialize_rpc.h"
+#include "serialize_replica.h"
+#include "serialize_checkpoint.h"
+#include "serialize_snapshot.h"
+#include "messages.h"
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -183,7 +203,7 @@ public:
         ms.read(is, valueFloat);
         ms.read(is, valueDouble);
         ms.read(is, color);
-        ms.read(is, cstr);
+        ms.read(is, cstr, sizeof(cstr));
         ms.read(is, str);
         ms.read(is, wstr);
         ms.read(is, dataVectorBool);
@@ -274,6 +294,66 @@ public:
     int dataNew = 0;    // NEW!
 };
 
+// Field layouts describe the write() order of each class for tools that process
+// encoded bytes without deserializing objects (see serialize_layout.h)
+static constexpr field_desc DateFields[] = {
+    layout_field("day", field_kind::INT16),
+    layout_field("month", field_kind::INT16),
+    layout_field("year", field_kind::INT16)
+};
+static constexpr type_layout DateLayout = make_layout("Date", DateFields);
+
+static constexpr field_desc AlarmLogFields[] = {
+    layout_field("logType", field_kind_of<Log::LogType>::value),
+    layout_object("date", DateLayout),
+    layout_field("alarmValue", field_kind::UINT32)
+};
+static constexpr type_layout AlarmLogLayout = make_layout("AlarmLog", AlarmLogFields);
+
+static constexpr field_desc AllDataFields[] = {
+    layout_field("valueInt", field_kind::INT32),
+    layout_field("valueInt8", field_kind::INT8),
+    layout_field("valueInt16", field_kind::INT16),
+    layout_field("valueInt32", field_kind::INT32),
+    layout_field("valueInt64", field_kind::INT64),
+    layout_field("valueUInt8", field_kind::UINT8),
+    layout_field("valueUInt16", field_kind::UINT16),
+    layout_field("valueUInt32", field_kind::UINT32),
+    layout_field("valueUInt64", field_kind::UINT64),
+    layout_field("valueFloat", field_kind::FLOAT),
+    layout_field("valueDouble", field_kind::DOUBLE),
+    layout_field("color", field_kind_of<Color>::value),
+    layout_field("cstr", field_kind::CSTRING),
+    layout_field("str", field_kind::STRING),
+    layout_field("wstr", field_kind::WSTRING),
+    layout_container("dataVectorBool", field_kind::VECTOR, field_kind::BOOL),
+    layout_container("dataVectorFloat", field_kind::VECTOR, field_kind::FLOAT),
+    layout_container("dataVectorPtr", field_kind::VECTOR, field_kind::OBJECT_PTR, DateLayout),
+    layout_container("dataVectorValue", field_kind::VECTOR, field_kind::OBJECT, DateLayout),
+    layout_container("dataVectorInt", field_kind::VECTOR, field_kind::INT32),
+    layout_container("dataListPtr", field_kind::LIST, field_kind::OBJECT_PTR, DateLayout),
+    layout_container("dataListValue", field_kind::LIST, field_kind::OBJECT, DateLayout),
+    layout_container("dataListInt", field_kind::LIST, field_kind::INT32),
+    layout_map("dataMapPtr", field_kind::INT32, field_kind::OBJECT_PTR, DateLayout),
+    layout_map("dataMapValue", field_kind::INT32, field_kind::OBJECT, DateLayout),
+    layout_map("dataMapInt", field_kind::INT32, field_kind::INT32),
+    layout_container("dataSetPtr", field_kind::SET, field_kind::OBJECT_PTR, DateLayout),
+    layout_container("dataSetValue", field_kind::SET, field_kind::OBJECT, DateLayout),
+    layout_container("dataSetInt", field_kind::SET, field_kind::INT32)
+};
+static constexpr type_layout AllDataLayout = make_layout("AllData", AllDataFields);
+
+static constexpr field_desc DataV1Fields[] = {
+    layout_field("data", field_kind::INT32)
+};
+static constexpr type_layout DataV1Layout = make_layout("Data", DataV1Fields);
+
+static constexpr field_desc DataV2Fields[] = {
+    layout_field("data", field_kind::INT32),
+    layout_field("dataNew", field_kind::INT32)
+};
+static constexpr type_layout DataV2Layout = make_layout("Data", DataV2Fields);
+
 void CreateData(AllData& data)
 {
     strcpy(data.cstr, "Hello World!");
@@ -476,6 +556,674 @@ int main(void)
             cout << "ERROR: dataV1" << endl;
     }
 
+    // Wire overhead analyzer example
+    {
+        AlarmLog alarmLog;
+        stringstream ss(ios::in | ios::out | ios::binary);
+        ms.write(ss, alarmLog);
+        string encoded = ss.str();
+
+        // Accumulate statistics from objects and from encoded buffers
+        wire_stats stats;
+        stats.analyze(alarmLog);
+        stats.analyze(outData);
+        stats.analyze<AlarmLog>(encoded.data(), encoded.size());
+        if (stats.getErrors() != 0)
+            cout << "ERROR: wire_stats" << endl;
+        stats.print(cout);
+    }
+
+    // Transcode encoded archive to CSV and JSON example
+    {
+        // Create an archive of AlarmLog records
+        stringstream archive(ios::in | ios::out | ios::binary);
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            AlarmLog alarmLog;
+            alarmLog.date = Date(1, 1, 2024);
+            alarmLog.alarmValue = i;
+            ms.write(archive, alarmLog);
+        }
+
+        transcoder csv(AlarmLogLayout, transcoder::Format::CSV);
+        if (!csv.transcode(archive, cout))
+            cout << "ERROR: transcode CSV" << endl;
+
+        stringstream ss(ios::in | ios::out | ios::binary);
+        ms.write(ss, outData);
+        transcoder json(AllDataLayout, transcoder::Format::JSON);
+        if (!json.transcode(ss, cout))
+            cout << "ERROR: transcode JSON" << endl;
+    }
+
+    // Columnar export example
+    {
+        stringstream archive(ios::in | ios::out | ios::binary);
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            AlarmLog alarmLog;
+            alarmLog.alarmValue = i;
+            ms.write(archive, alarmLog);
+        }
+
+        // Convert the archive to a columnar file
+        columnar_writer writer(AlarmLogLayout);
+        stringstream columnarFile(ios::in | ios::out | ios::binary);
+        if (!writer.add(archive) || !writer.write(columnarFile))
+            cout << "ERROR: columnar_writer" << endl;
+
+        // Scan one contiguous column
+        columnar_reader reader;
+        const columnar_reader::column* column = nullptr;
+        if (reader.read(columnarFile) && (column = reader.find("alarmValue")) != nullptr)
+        {
+            const uint32_t* values = reinterpret_cast<const uint32_t*>(column->values);
+            uint64_t sum = 0;
+            for (uint64_t i = 0; i < reader.getRows(); i++)
+                sum += values[i];
+            cout << "Columnar alarmValue sum: " << sum << endl;
+        }
+        else
+        {
+            cout << "ERROR: columnar_reader" << endl;
+        }
+    }
+
+    // Result code encode and decode example
+    {
+        vector<char> buf;
+        serialize::result r = ms.encode(outData, buf);
+        if (!r.ok())
+            cout << "ERROR: encode " << (int)r.error << " at " << r.offset << endl;
+
+        AllData allData;
+        r = ms.decode(buf.data(), buf.size(), allData);
+        if (r.ok())
+            cout << "Decoded " << r.offset << " bytes" << endl;
+
+        // A truncated buffer reports the error and byte offset
+        r = ms.decode(buf.data(), buf.size() / 2, allData);
+        if (!r.ok())
+            cout << "Truncated decode error " << (int)r.error << " at " << r.offset << endl;
+    }
+
+    // Depth bounded decode example
+    {
+        vector<char> buf;
+        ms.encode(outData, buf);
+
+        // AllData contains nested Date objects, so a depth of 1 is exceeded
+        serialize shallow;
+        shallow.setMaxDepth(1);
+        AllData allData;
+        serialize::result r = shallow.decode(buf.data(), buf.size(), allData);
+        if (r.error == serialize::ParsingError::DEPTH_EXCEEDED)
+            cout << "Depth exceeded at " << r.offset << endl;
+    }
+
+    // Decode budget example
+    {
+        vector<char> buf;
+        ms.encode(outData, buf);
+
+        // Allow fewer container elements than AllData holds
+        serialize::decode_budget budget;
+        budget.elements = 8;
+        budget.time = chrono::milliseconds(10);
+        serialize limited;
+        limited.setDecodeBudget(budget);
+        AllData allData;
+        serialize::result r = limited.decode(buf.data(), buf.size(), allData);
+        if (r.error == serialize::ParsingError::BUDGET_EXCEEDED)
+            cout << "Budget exceeded at " << r.offset << " after " << limited.getDecodeUsage().elements << " elements" << endl;
+
+        // A top-level container is one message, so its element allocations add up
+        budget = serialize::decode_budget();
+        budget.allocations = 1;
+        limited.setDecodeBudget(budget);
+        ms.encode(outData.dataVectorPtr, buf);
+        vector<Date*> dates;
+        r = limited.decode(buf.data(), buf.size(), dates);
+        if (r.error == serialize::ParsingError::BUDGET_EXCEEDED)
+            cout << "Budget exceeded after " << limited.getDecodeUsage().allocations << " allocations" << endl;
+        for (Date* date : dates)
+            delete date;
+    }
+
+    // Schema handshake example
+    {
+        // Fingerprints are computed at compile time
+        constexpr uint64_t alarmLogFingerprint = schema_fingerprint(AlarmLogLayout);
+        static_assert(alarmLogFingerprint != schema_fingerprint(DateLayout), "Fingerprint collision");
+
+        // The peer only supports the tagged mode for AllData
+        schema_handshake local, peer;
+        local.add(AlarmLogLayout);
+        local.add(AllDataLayout);
+        peer.add(AlarmLogLayout);
+        peer.add(AllDataLayout, schema_handshake::modeBit(serialize::WireMode::TAGGED));
+
+        vector<char> localHello, peerHello;
+        local.writeHello(localHello);
+        peer.writeHello(peerHello);
+        local.readHello(peerHello.data(), peerHello.size());
+        peer.readHello(localHello.data(), localHello.size());
+
+        // Encode with the agreed mode of each message type
+        AlarmLog alarmLog;
+        vector<char> tagged, untagged;
+        ms.encode(alarmLog, tagged);
+        ms.setWireMode(local.getMode(AlarmLogLayout));
+        ms.encode(alarmLog, untagged);
+        ms.setWireMode(serialize::WireMode::TAGGED);
+
+        serialize peerMs;
+        peerMs.setWireMode(peer.getMode(AlarmLogLayout));
+        AlarmLog readLog;
+        if (peerMs.decode(untagged.data(), untagged.size(), readLog).ok())
+            cout << "AlarmLog tagged " << tagged.size() << " bytes, untagged " << untagged.size() << " bytes" << endl;
+        if (local.getMode(AllDataLayout) != serialize::WireMode::TAGGED)
+            cout << "ERROR: schema_handshake" << endl;
+    }
+
+    // Generated message example (see messages.idl)
+    {
+        Track track;
+        track.trackId = 7;
+        track.status = Status::ACTIVE;
+        strcpy(track.callsign, "ALPHA");
+        track.position.latitude = 45000000;
+        track.history.push_back(track.position);
+        track.route.push_back(new Waypoint());
+        track.waypoints[1].position.altitude = 100.0f;
+        track.tags.insert(42);
+
+        vector<char> buf;
+        ms.encode(track, buf);
+        Track readTrack;
+        if (ms.decode(buf.data(), buf.size(), readTrack).ok() && readTrack.waypoints[1].position.altitude == 100.0f)
+            cout << "Track " << readTrack.trackId << " " << readTrack.callsign << " decoded" << endl;
+
+        // A sender's callsign longer than Track's char[16] is rejected, not overrun
+        struct LongCallsign : public serialize::I
+        {
+            virtual ostream& write(serialize& ms, ostream& os) override
+            {
+                ms.write(os, trackId);
+                ms.write(os, status);
+                ms.write(os, callsign);
+                return os;
+            }
+            virtual istream& read(serialize&, istream& is) override { return is; }
+
+            uint32_t trackId = 8;
+            Status status = Status::ACTIVE;
+            string callsign = string(40, 'C');
+        } longCallsign;
+        ms.encode(longCallsign, buf);
+        serialize peer;
+        Track longTrack;
+        if (peer.decode(buf.data(), buf.size(), longTrack).error == serialize::ParsingError::STRING_TOO_LONG)
+            cout << "Track callsign of " << longCallsign.callsign.size() << " chars rejected" << endl;
+
+        // Read fields of a fixed size message without decoding
+        Waypoint waypoint;
+        waypoint.id = 3;
+        waypoint.position.longitude = -122000000;
+        ms.encode(waypoint, buf);
+        static_assert(Waypoint::FIXED_SIZE && Waypoint::ENCODED_SIZE == 24, "Unexpected Waypoint size");
+        if (Waypoint::view::valid(buf.data(), buf.size()))
+        {
+            Waypoint::view view(buf.data());
+            cout << "Waypoint view " << view.id() << " " << view.position().longitude() << endl;
+        }
+
+        // Decode with the table driven decode plan
+        Waypoint planned;
+        serialize::result r = WaypointPlan().decode(buf.data(), buf.size(), planned);
+        if (r.ok() && planned.id == waypoint.id && planned.position.longitude == waypoint.position.longitude)
+            cout << "Waypoint plan " << WaypointPlan().getOperations() << " operations, " << r.offset << " bytes decoded" << endl;
+    }
+
+    // Upgrade encoded DataV1 records to DataV2 without decoding
+    {
+        vector<char> archive, record;
+        for (int i = 1; i <= 3; i++)
+        {
+            DataV1 dataV1;
+            dataV1.data = i;
+            ms.encode(dataV1, record);
+            archive.insert(archive.end(), record.begin(), record.end());
+        }
+
+        version_upgrader upgrader(DataV1Layout, DataV2Layout);
+        vector<char> upgraded;
+        serialize::result r = upgrader.upgrade(archive.data(), archive.size(), upgraded);
+
+        DataV2 dataV2;
+        dataV2.dataNew = -1;
+        size_t last = upgraded.size() / 3 * 2;
+        if (r.ok() && ms.decode(upgraded.data() + last, upgraded.size() - last, dataV2).ok() &&
+            dataV2.data == 3 && dataV2.dataNew == 0)
+            cout << "Upgraded " << archive.size() << " bytes to " << upgraded.size() << " bytes" << endl;
+    }
+
+    // Canonical encoding and content hash example
+    {
+        // Equal dates allocated in a different order
+        Date* first = new Date(1, 2, 2024);
+        Date* second = new Date(3, 4, 2024);
+        set<Date*> dates1 = { first, second };
+        Date* third = new Date(3, 4, 2024);
+        Date* fourth = new Date(1, 2, 2024);
+        set<Date*> dates2 = { third, fourth };
+
+        vector<char> buf1, buf2;
+        content_hash hash1, hash2;
+        encode_hashed(ms, dates1, buf1, hash1);
+        encode_hashed(ms, dates2, buf2, hash2);
+        if (hash1 == hash2 && buf1 == buf2)
+            cout << "Canonical encoding " << buf1.size() << " bytes, equal hashes" << endl;
+
+        vector<float> zero = { 0.0f }, negativeZero = { -0.0f };
+        encode_hashed(ms, zero, buf1, hash1);
+        encode_hashed(ms, negativeZero, buf2, hash2);
+        if (hash1 != hash2)
+            cout << "ERROR: canonical float" << endl;
+
+        for (Date* d : { first, second, third, fourth })
+            delete d;
+    }
+
+    // Structural diff and patch example
+    {
+        AllData leader;
+        CreateData(leader);
+        vector<char> oldBytes, newBytes;
+        ms.encode(leader, oldBytes);
+
+        leader.valueInt = 42;
+        leader.dataVectorInt.push_back(4);
+        leader.dataMapValue[1].year = 2025;
+        ms.encode(leader, newBytes);
+
+        layout_diff differ(AllDataLayout);
+        vector<char> delta, patched;
+        if (differ.diff(oldBytes.data(), oldBytes.size(), newBytes.data(), newBytes.size(), delta) &&
+            differ.patch(oldBytes.data(), oldBytes.size(), delta.data(), delta.size(), patched) &&
+            patched == newBytes)
+            cout << "Delta " << delta.size() << " bytes for " << newBytes.size() << " byte message" << endl;
+        else
+            cout << "ERROR: layout_diff " << (int)differ.getLastError() << endl;
+    }
+
+    // In-process message bus example
+    {
+        message_bus<AlarmLog> bus(ms);
+        uint32_t localSum = 0;
+        size_t remoteBytes = 0;
+        bus.subscribeLocal([&](const shared_ptr<const AlarmLog>& log) { localSum += log->alarmValue; });
+        bus.subscribeLocal([&](const shared_ptr<const AlarmLog>& log) { localSum += log->alarmValue; });
+
+        // Local subscribers only: nothing is encoded
+        auto alarm = make_shared<AlarmLog>();
+        alarm->alarmValue = 5;
+        bus.publish(alarm);
+
+        // Remote subscribers share one encoding
+        bus.subscribeRemote([&](const shared_ptr<const vector<char>>& bytes) { remoteBytes += bytes->size(); });
+        size_t remote = bus.subscribeRemote([&](const shared_ptr<const vector<char>>& bytes) { remoteBytes += bytes->size(); });
+        bus.publish(alarm);
+        bus.unsubscribe(remote);
+
+        if (localSum == 20 && bus.getEncodeCount() == 1)
+            cout << "Bus local sum " << localSum << ", remote bytes " << remoteBytes << ", encodes " << bus.getEncodeCount() << endl;
+    }
+
+    // Batch of messages with one header example
+    {
+        const uint16_t ALARM_LOG_ID = 1;
+        vector<AlarmLog> alarmLogs(10);
+        for (size_t i = 0; i < alarmLogs.size(); i++)
+            alarmLogs[i].alarmValue = static_cast<uint32_t>(i);
+
+        vector<char> compact, batch;
+        encode_batch(ms, ALARM_LOG_ID, alarmLogs, compact);
+        encode_batch(ms, ALARM_LOG_ID, alarmLogs, batch, true);
+
+        vector<AlarmLog> received;
+        serialize::result r = decode_batch(ms, ALARM_LOG_ID, batch.data(), batch.size(), received);
+
+        // Read one message using the offset table
+        batch_view view(batch.data(), batch.size());
+        const char* message = nullptr;
+        size_t messageSize = 0;
+        AlarmLog last;
+        if (r.ok() && received.size() == 10 && received[9].alarmValue == 9 &&
+            view.getMessage(9, message, messageSize) && ms.decode(message, messageSize, last).ok() && last.alarmValue == 9)
+            cout << "Batch of " << received.size() << " in " << compact.size() << " bytes, " << batch.size() << " with offset table" << endl;
+    }
+
+    // Coalescing writer example
+    {
+        coalescing_writer::limits limits;
+        limits.messages = 4;
+        limits.delay = chrono::microseconds(500);
+        size_t sends = 0, sent = 0;
+        coalescing_writer writer([&](const char*, size_t size) { sends++; sent += size; }, limits);
+
+        AlarmLog alarmLog;
+        for (int i = 0; i < 10; i++)
+            writer.write(ms, alarmLog);
+        writer.flush();
+
+        if (writer.getFlushes(coalescing_writer::Flush::MESSAGES) + writer.getFlushes(coalescing_writer::Flush::DELAY) >= 2 &&
+            writer.getLatency().getCount() == 10)
+            cout << "Coalesced 10 messages into " << sends << " sends of " << sent << " bytes" << endl;
+    }
+
+    // Credit-based flow control example
+    {
+        // The receiver allows 4 unconsumed messages. The sender pool holds 4 more.
+        credit_receiver receiver(1024, 4);
+        list<vector<char>> wire;
+        credit_sender sender([&](const char* data, size_t size) { wire.emplace_back(data, data + size); },
+            4, 256, credit_sender::Policy::DROP);
+
+        vector<char> grant;
+        credit_grant g;
+        receiver.getInitialGrant().write(grant);
+        if (g.read(grant.data(), grant.size()))
+            sender.grant(g);
+
+        // Produce faster than the receiver consumes
+        AlarmLog alarmLog;
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            alarmLog.alarmValue = i;
+            sender.write(ms, alarmLog);
+        }
+
+        // Consume and return credits
+        serialize peer;
+        uint32_t last = 0;
+        while (!wire.empty())
+        {
+            AlarmLog received;
+            if (peer.decode(wire.front().data(), wire.front().size(), received).ok())
+                last = received.alarmValue;
+            bool grantNow = receiver.consume(wire.front().size());
+            wire.pop_front();
+            if (grantNow)
+            {
+                receiver.takeGrant().write(grant);
+                if (g.read(grant.data(), grant.size()))
+                    sender.grant(g);
+            }
+        }
+
+        if (last == 7 && sender.getQueued() == 0)
+            cout << "Flow control sent " << sender.getSent() << ", dropped " << sender.getDropped() << " of 20 messages" << endl;
+    }
+
+    // Priority lane scheduler example
+    {
+        const size_t ALARM_LANE = 0, BULK_LANE = 1;
+        size_t chunks = 0, alarmChunk = 0, snapshotSize = 0;
+        serialize peer;
+        chunk_assembler assembler([&](size_t lane, const char* data, size_t size)
+        {
+            AlarmLog alarm;
+            if (lane == ALARM_LANE && peer.decode(data, size, alarm).ok())
+                alarmChunk = chunks;
+            else if (lane == BULK_LANE)
+                snapshotSize = size;
+        }, 2);
+        message_scheduler scheduler([&](const char* data, size_t size) { chunks++; assembler.receive(data, size); }, 2, 64);
+
+        // An alarm raised while a snapshot is being sent preempts the rest of it
+        scheduler.enqueue(ms, outData, BULK_LANE);
+        scheduler.sendNext();
+        AlarmLog alarmLog;
+        scheduler.enqueue(ms, alarmLog, ALARM_LANE);
+        scheduler.flush();
+
+        if (assembler.good() && alarmChunk == 2 && snapshotSize > 0)
+            cout << "Alarm sent as chunk " << alarmChunk << " of " << chunks << ", preempting " << snapshotSize << " byte snapshot" << endl;
+    }
+
+    // Datagram fragmentation example
+    {
+        // Datagrams arrive reordered and duplicated
+        vector<vector<char>> datagrams;
+        fragmenter frag([&](const char* data, size_t size) { datagrams.emplace_back(data, data + size); }, 128);
+        frag.send(ms, outData);
+        reverse(datagrams.begin(), datagrams.end());
+        datagrams.push_back(datagrams.front());
+
+        serialize peer;
+        AllData received;
+        size_t messageSize = 0;
+        reassembler reasm([&](const char* data, size_t size)
+        {
+            if (peer.decode(data, size, received).ok())
+                messageSize = size;
+        });
+        for (const vector<char>& datagram : datagrams)
+            reasm.receive(datagram.data(), datagram.size());
+
+        if (reasm.getCompleted() == 1 && reasm.getDuplicates() == 1 && received.str == outData.str && received.dataMapInt == outData.dataMapInt)
+            cout << "Reassembled " << messageSize << " bytes from " << datagrams.size() - 1 << " fragments" << endl;
+    }
+
+    // Stream resynchronization example
+    {
+        vector<char> stream;
+        vector<size_t> frameStart;
+        AlarmLog alarmLog;
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            alarmLog.alarmValue = i;
+            frameStart.push_back(stream.size());
+            encode_frame(ms, alarmLog, stream);
+        }
+
+        // Lose a byte of frame 3 and corrupt a byte of frame 6
+        stream[frameStart[6] + 10] ^= 0x40;
+        stream.erase(stream.begin() + frameStart[3] + 8);
+
+        serialize peer;
+        uint32_t valueSum = 0;
+        frame_reader reader([&](const char* data, size_t size)
+        {
+            AlarmLog received;
+            if (peer.decode(data, size, received).ok())
+                valueSum += received.alarmValue;
+        });
+        for (size_t offset = 0; offset < stream.size(); offset += 16)
+            reader.receive(stream.data() + offset, min<size_t>(16, stream.size() - offset));
+
+        if (valueSum == 45 - 3 - 6)
+            cout << "Resynchronized " << reader.getFrames() << " of 10 frames, skipped " << reader.getSkipped() << " bytes" << endl;
+    }
+
+    // Request/response RPC example
+    {
+        const uint16_t GET_ALARM_DATE = 1, UNKNOWN = 2;
+
+        // In-memory connection carrying whole RPC messages
+        list<vector<char>> toServer, toClient;
+        rpc_client client([&](const char* data, size_t size) { toServer.emplace_back(data, data + size); });
+        rpc_server server([&](const char* data, size_t size) { toClient.emplace_back(data, data + size); });
+        server.bind<AlarmLog, Date>(GET_ALARM_DATE, [](AlarmLog& log, Date& date) { date = log.date; });
+
+        // Pipeline calls before any response arrives
+        vector<future<rpc_reply<Date>>> replies;
+        AlarmLog alarmLog;
+        for (int16_t day = 1; day <= 10; day++)
+        {
+            alarmLog.date = Date(day, 1, 2024);
+            replies.push_back(client.call<Date>(GET_ALARM_DATE, alarmLog));
+        }
+        rpc::Status unknownStatus = rpc::Status::OK;
+        client.call<Date>(UNKNOWN, alarmLog, [&](rpc::Status status, Date&) { unknownStatus = status; });
+
+        for (const vector<char>& request : toServer)
+            server.receive(request.data(), request.size());
+        for (const vector<char>& response : toClient)
+            client.receive(response.data(), response.size());
+
+        int16_t daySum = 0;
+        for (auto& reply : replies)
+        {
+            rpc_reply<Date> r = reply.get();
+            if (r.ok())
+                daySum += r.response.day;
+        }
+        if (daySum == 55 && unknownStatus == rpc::Status::UNKNOWN_METHOD && client.getPending() == 0)
+            cout << "RPC " << replies.size() << " pipelined calls completed, unknown method rejected" << endl;
+    }
+
+    // Log replication example
+    {
+        segment_log::remove("leader.log");
+        segment_log::remove("follower.log");
+        {
+            list<vector<char>> toLeader, toFollower;
+            segment_log leaderLog("leader.log", 1024);
+            segment_log followerLog("follower.log", 1024);
+            log_leader leader(leaderLog, [&](const char* data, size_t size) { toFollower.emplace_back(data, data + size); });
+            log_follower follower(followerLog, [&](const char* data, size_t size) { toLeader.emplace_back(data, data + size); });
+            auto deliver = [&]()
+            {
+                while (!toLeader.empty() || !toFollower.empty())
+                {
+                    for (; !toLeader.empty(); toLeader.pop_front())
+                        leader.receive(toLeader.front().data(), toLeader.front().size());
+                    for (; !toFollower.empty(); toFollower.pop_front())
+                        follower.receive(toFollower.front().data(), toFollower.front().size());
+                }
+            };
+
+            // Records archived before the follower connects are caught up from the segment files
+            AlarmLog alarmLog;
+            for (uint32_t i = 0; i < 50; i++)
+            {
+                alarmLog.alarmValue = i;
+                leaderLog.append(ms, alarmLog);
+            }
+            follower.connect();
+            deliver();
+
+            // Live records, then a lost batch and a reconnect
+            for (uint32_t i = 50; i < 100; i++)
+            {
+                alarmLog.alarmValue = i;
+                leaderLog.append(ms, alarmLog);
+                if (i % 10 == 9)
+                {
+                    leader.pump();
+                    if (i == 79)
+                    {
+                        toFollower.clear();
+                        leader.disconnect();
+                        follower.connect();
+                    }
+                    deliver();
+                }
+            }
+
+            auto readAll = [](segment_log& log, vector<char>& out)
+            {
+                while (out.size() < log.getEndOffset() && log.read(out.size(), 1 << 20, out)) {}
+            };
+            vector<char> leaderBytes, followerBytes;
+            readAll(leaderLog, leaderBytes);
+            readAll(followerLog, followerBytes);
+            if (leaderBytes == followerBytes && leader.getAcked() == leaderLog.getEndOffset())
+                cout << "Replicated " << followerBytes.size() << " bytes in " << followerLog.getSegmentCount() << " segments, acked " << leader.getAcked() << endl;
+        }
+        segment_log::remove("leader.log");
+        segment_log::remove("follower.log");
+    }
+
+    // Incremental checkpoint example
+    {
+        checkpoint_store::remove("state");
+        vector<char> saved, recovered;
+        uint64_t deltaBytes = 0;
+        {
+            checkpoint_store store(AllDataLayout, "state");
+            int valueInt = outData.valueInt;
+            for (int i = 1; i < 10; i++)
+            {
+                outData.valueInt = valueInt + i;
+                store.save(ms, outData);
+            }
+            outData.valueInt = valueInt;
+            deltaBytes = store.getDeltaBytes();
+            ms.encode(outData, saved);
+            store.save(saved.data(), saved.size());
+        }
+        {
+            // Recover from the base and the delta chain
+            checkpoint_store store(AllDataLayout, "state");
+            store.load(recovered);
+        }
+        checkpoint_store::remove("state");
+
+        if (recovered == saved)
+            cout << "Checkpointed " << saved.size() << " byte state 10 times in " << deltaBytes << " delta bytes, recovered" << endl;
+    }
+
+    // Background snapshot encoding example
+    {
+        // The writer keeps alarmValue and date.day consistent; a torn snapshot would not be
+        snapshot_cell<AlarmLog> state;
+        state.update([](AlarmLog& log) { log.date.day = 1; });
+        serialize peer;
+        int torn = 0;
+        snapshot_encoder<AlarmLog> encoder(state, [&](const char* data, size_t size)
+        {
+            AlarmLog snap;
+            if (!peer.decode(data, size, snap).ok() || snap.date.day != static_cast<int16_t>(snap.alarmValue % 28 + 1))
+                torn++;
+        });
+
+        std::thread writer([&]()
+        {
+            for (uint32_t i = 0; i < 10000; i++)
+            {
+                state.update([i](AlarmLog& log)
+                {
+                    log.alarmValue = i;
+                    log.date.day = static_cast<int16_t>(i % 28 + 1);
+                });
+            }
+        });
+        for (int i = 0; i < 100; i++)
+            encoder.request();
+        writer.join();
+        encoder.request();
+        encoder.wait();
+
+        if (torn == 0 && encoder.getEncoded() > 0)
+            cout << "Snapshots encoded during 10000 updates, none torn" << endl;
+    }
+
+    // std::wstring wire format example
+    {
+        // Each character is 16 bits big endian on every platform, whatever sizeof(wchar_t)
+        wstring wide = L"Wide", decoded;
+        vector<char> buf;
+        ms.encode(wide, buf);
+        const char expected[] = { 9, 0, 4, 0, 'W', 0, 'i', 0, 'd', 0, 'e' };
+        serialize peer;
+        if (buf.size() == sizeof(expected) && memcmp(buf.data(), expected, sizeof(expected)) == 0 &&
+            peer.decode(buf.data(), buf.size(), decoded).ok() && decoded == wide)
+            cout << "std::wstring encoded as " << buf.size() - 3 << " bytes of UTF-16BE" << endl;
+    }
+
     // TODO: Send serialized data to another CPU as part of a 
     // send/receive binary protocol.
 
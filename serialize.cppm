@@ -0,0 +1,19 @@
+/// @file serialize.cppm
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+///
+/// C++20 module interface for the serializer. Importing translation units use
+/// the compiled module instead of reparsing serialize.h and the standard 
+/// container headers. e.g.
+///
+/// import serialize;
+
+module;
+
+// Global module fragment. The headers are compiled once with the module.
+#include "serialize.h"
+
+export module serialize;
+
+export using ::serialize;
+export using ::serialize_container;
@@ -0,0 +1,184 @@
+/// @file serialize_batch.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_BATCH_H
+#define _SERIALIZE_BATCH_H
+
+#include "serialize_core.h"
+#include <vector>
+
+/// @brief The batch_view class reads the header of a batch of messages of one
+/// type encoded by encode_batch().
+/// @detail A batch sends a header once followed by the messages back to back,
+/// so a burst of small messages is one buffer and one send. Each message keeps
+/// its USER_DEFINED type and size so older and newer receivers still skip or
+/// default fields. Batch encoding, big endian:
+///
+///     u8 version, u8 flags, u16 type id, u16 count,
+///     [u32 message offset from the body start, per message if OFFSET_TABLE],
+///     body
+///
+/// The offset table allows reading one message without decoding the others.
+class batch_view
+{
+public:
+    static const uint8_t VERSION = 1;
+    static const uint8_t OFFSET_TABLE = 0x01;
+    static const size_t HEADER_SIZE = 6;
+
+    /// @param[in] data - the batch bytes. Must outlive the view.
+    /// @param[in] size - the number of bytes
+    batch_view(const char* data_, size_t size_) : data(data_), size(size_)
+    {
+        if (size < HEADER_SIZE || static_cast<uint8_t>(data[0]) != VERSION)
+        {
+            error = size < HEADER_SIZE ? serialize::ParsingError::END_OF_FILE : serialize::ParsingError::INVALID_INPUT;
+            return;
+        }
+        flags = static_cast<uint8_t>(data[1]);
+        typeId = load(data + 2, 2);
+        count = load(data + 4, 2);
+        body = HEADER_SIZE + (hasOffsets() ? 4 * count : 0);
+        if (body > size)
+            error = serialize::ParsingError::END_OF_FILE;
+    }
+
+    bool good() const { return error == serialize::ParsingError::NONE; }
+    serialize::ParsingError getLastError() const { return error; }
+
+    uint16_t getTypeId() const { return static_cast<uint16_t>(typeId); }
+    uint16_t getCount() const { return static_cast<uint16_t>(count); }
+    bool hasOffsets() const { return (flags & OFFSET_TABLE) != 0; }
+
+    /// Get the message bytes, from the body start to the end of the batch.
+    const char* getBody() const { return data + body; }
+    size_t getBodySize() const { return size - body; }
+    size_t getBodyOffset() const { return body; }
+
+    /// Get the bytes of one message using the offset table.
+    /// @param[in] index - the message index
+    /// @param[out] message - the message bytes
+    /// @param[out] messageSize - the number of bytes
+    /// @return True if the message is within the batch.
+    bool getMessage(size_t index, const char*& message, size_t& messageSize) const
+    {
+        if (!good() || !hasOffsets() || index >= count)
+            return false;
+        size_t begin = load(data + HEADER_SIZE + 4 * index, 4);
+        size_t end = index + 1 < count ? load(data + HEADER_SIZE + 4 * (index + 1), 4) : getBodySize();
+        if (begin > end || end > getBodySize())
+            return false;
+        message = getBody() + begin;
+        messageSize = end - begin;
+        return true;
+    }
+
+private:
+    static size_t load(const char* p, size_t bytes)
+    {
+        size_t value = 0;
+        for (size_t i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+
+    const char* data;
+    size_t size;
+    uint8_t flags = 0;
+    size_t typeId = 0;
+    size_t count = 0;
+    size_t body = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+/// Encode messages of one type as a batch with one header. e.g.
+///
+/// encode_batch(ms, ALARM_LOG_ID, alarmLogs, buf);
+///
+/// @param[in] ms - the serialize instance
+/// @param[in] typeId - the application message type id
+/// @param[in] messages - the messages
+/// @param[out] out - the batch bytes. Existing contents are replaced.
+/// @param[in] offsetTable - true to include the message offset table
+/// @return The first error and its byte offset within the body, or the number
+/// of bytes encoded.
+template <class T>
+serialize::result encode_batch(serialize& ms, uint16_t typeId, std::vector<T>& messages,
+    std::vector<char>& out, bool offsetTable = false)
+{
+    serialize::result r;
+    if (messages.size() > 0xFFFF)
+    {
+        r.error = serialize::ParsingError::CONTAINER_TOO_MANY;
+        return r;
+    }
+
+    // Encode the body, then insert the header in front of it
+    r = ms.encode(messages.data(), messages.size(), out);
+    if (!r.ok())
+        return r;
+
+    std::vector<char> header;
+    header.reserve(batch_view::HEADER_SIZE + (offsetTable ? 4 * messages.size() : 0));
+    auto put = [&header](size_t value, size_t bytes)
+    {
+        for (size_t i = bytes; i > 0; i--)
+            header.push_back(static_cast<char>(value >> (8 * (i - 1))));
+    };
+    put(batch_view::VERSION, 1);
+    put(offsetTable ? batch_view::OFFSET_TABLE : 0, 1);
+    put(typeId, 2);
+    put(messages.size(), 2);
+    if (offsetTable)
+    {
+        // Each message starts with its USER_DEFINED type and size
+        size_t offset = 0;
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            put(offset, 4);
+            offset += 1 + ((static_cast<uint8_t>(out[offset + 1]) << 8) | static_cast<uint8_t>(out[offset + 2]));
+        }
+    }
+    out.insert(out.begin(), header.begin(), header.end());
+    r.offset = out.size();
+    return r;
+}
+
+/// Decode a batch into a vector in one pass. The vector is resized to the
+/// batch count, reusing its existing elements and capacity. e.g.
+///
+/// std::vector<AlarmLog> alarmLogs;
+/// serialize::result r = decode_batch(ms, ALARM_LOG_ID, data, size, alarmLogs);
+///
+/// @param[in] ms - the serialize instance
+/// @param[in] typeId - the expected application message type id
+/// @param[in] data - the batch bytes
+/// @param[in] size - the number of bytes
+/// @param[out] messages - the decoded messages
+/// @return The first error and its byte offset, or the number of bytes decoded.
+template <class T>
+serialize::result decode_batch(serialize& ms, uint16_t typeId, const char* data, size_t size, std::vector<T>& messages)
+{
+    serialize::result r;
+    batch_view view(data, size);
+    if (!view.good() || view.getTypeId() != typeId)
+    {
+        r.error = view.good() ? serialize::ParsingError::TYPE_MISMATCH : view.getLastError();
+        return r;
+    }
+
+    // Every message has at least a USER_DEFINED type and size
+    if (view.getCount() > view.getBodySize() / 3)
+    {
+        r.error = serialize::ParsingError::END_OF_FILE;
+        return r;
+    }
+
+    messages.resize(view.getCount());
+    r = ms.decode(view.getBody(), view.getBodySize(), messages.data(), messages.size());
+    r.offset += view.getBodyOffset();
+    return r;
+}
+
+#endif // _SERIALIZE_BATCH_H
@@ -0,0 +1,114 @@
+/// @file serialize_bus.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_BUS_H
+#define _SERIALIZE_BUS_H
+
+#include "serialize_core.h"
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// @brief The message_bus class delivers published messages of one type to
+/// local and remote subscribers.
+/// @detail Local subscribers in the same process receive the published object
+/// itself as a shared immutable object; nothing is serialized for them. The
+/// message is encoded only if a remote subscriber (e.g. a socket or IPC sender)
+/// exists, and then only once. All remote subscribers share the same bytes. e.g.
+///
+/// message_bus<AlarmLog> bus(ms);
+/// bus.subscribeLocal([](const std::shared_ptr<const AlarmLog>& log) { ... });
+/// bus.subscribeRemote([](const std::shared_ptr<const std::vector<char>>& bytes) { send(*bytes); });
+/// bus.publish(std::make_shared<const AlarmLog>(alarmLog));
+///
+/// Handlers are called synchronously by publish(). Subscribers may keep the
+/// shared pointers. A handler must not subscribe or unsubscribe. The bus is not
+/// thread safe.
+template <class T>
+class message_bus
+{
+public:
+    typedef std::function<void(const std::shared_ptr<const T>&)> LocalHandler;
+    typedef std::function<void(const std::shared_ptr<const std::vector<char>>&)> RemoteHandler;
+
+    /// @param[in] ms_ - the serialize instance used to encode for remote subscribers
+    explicit message_bus(serialize& ms_) : ms(ms_)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+    }
+
+    /// Subscribe within the process.
+    /// @return The subscription id
+    size_t subscribeLocal(LocalHandler handler)
+    {
+        locals.emplace_back(++lastId, std::move(handler));
+        return lastId;
+    }
+
+    /// Subscribe to the encoded bytes of each message.
+    /// @return The subscription id
+    size_t subscribeRemote(RemoteHandler handler)
+    {
+        remotes.emplace_back(++lastId, std::move(handler));
+        return lastId;
+    }
+
+    /// Remove a local or remote subscription.
+    void unsubscribe(size_t id)
+    {
+        erase(locals, id);
+        erase(remotes, id);
+    }
+
+    /// Publish a message to all subscribers.
+    /// @param[in] message - the message. Must not be modified after publishing.
+    /// @return The encode result, or success if there is no remote subscriber.
+    serialize::result publish(const std::shared_ptr<const T>& message)
+    {
+        for (auto& local : locals)
+            local.second(message);
+
+        serialize::result r;
+        if (remotes.empty())
+            return r;
+
+        // Encode once for all remote subscribers. write() does not modify the object.
+        std::shared_ptr<std::vector<char>> bytes = std::make_shared<std::vector<char>>();
+        r = ms.encode(const_cast<T&>(*message), *bytes);
+        encodes++;
+        if (!r.ok())
+            return r;
+
+        std::shared_ptr<const std::vector<char>> shared = bytes;
+        for (auto& remote : remotes)
+            remote.second(shared);
+        return r;
+    }
+
+    /// Get the number of messages encoded for remote subscribers.
+    size_t getEncodeCount() const { return encodes; }
+
+private:
+    template <class H>
+    static void erase(std::vector<std::pair<size_t, H>>& handlers, size_t id)
+    {
+        for (auto it = handlers.begin(); it != handlers.end(); ++it)
+        {
+            if (it->first == id)
+            {
+                handlers.erase(it);
+                return;
+            }
+        }
+    }
+
+    serialize& ms;
+    std::vector<std::pair<size_t, LocalHandler>> locals;
+    std::vector<std::pair<size_t, RemoteHandler>> remotes;
+    size_t lastId = 0;
+    size_t encodes = 0;
+};
+
+#endif // _SERIALIZE_BUS_H
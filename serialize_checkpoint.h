@@ -0,0 +1,442 @@
+/// @file serialize_checkpoint.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_CHECKPOINT_H
+#define _SERIALIZE_CHECKPOINT_H
+
+#include "serialize_diff.h"
+#include "serialize_frame.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SERIALIZE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SERIALIZE_MMAP 0
+#endif
+
+/// @brief A read only view of a whole file. The file is memory mapped where
+/// mmap() is available and read into memory otherwise.
+class mapped_file
+{
+public:
+    explicit mapped_file(const std::string& name)
+    {
+#if SERIALIZE_MMAP
+        int fd = ::open(name.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0)
+        {
+            length = static_cast<size_t>(st.st_size);
+            opened = true;
+            if (length > 0)
+            {
+                void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                map = p == MAP_FAILED ? nullptr : p;
+                opened = map != nullptr;
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream f(name, std::ios::binary | std::ios::ate);
+        if (!f)
+            return;
+        buffer.resize(static_cast<size_t>(f.tellg()));
+        f.seekg(0);
+        f.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        opened = static_cast<size_t>(f.gcount()) == buffer.size();
+#endif
+    }
+
+    ~mapped_file()
+    {
+#if SERIALIZE_MMAP
+        if (map != nullptr)
+            munmap(map, length);
+#endif
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool good() const { return opened; }
+
+#if SERIALIZE_MMAP
+    const char* data() const { return static_cast<const char*>(map); }
+    size_t size() const { return length; }
+#else
+    const char* data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
+#endif
+
+private:
+    bool opened = false;
+#if SERIALIZE_MMAP
+    void* map = nullptr;
+    size_t length = 0;
+#else
+    std::vector<char> buffer;
+#endif
+};
+
+/// @brief The checkpoint_store class saves incremental checkpoints of an
+/// encoded state object as a base snapshot plus a chain of field-level deltas.
+/// @detail Each save() appends the layout_diff delta from the previous
+/// checkpoint, so checkpoint I/O scales with the rate of change instead of
+/// the state size. When the chain grows too long, it is consolidated: the
+/// current state becomes the base of a new epoch, written by a background
+/// thread, while later deltas go to the new epoch's delta file. Files are:
+///
+///     path.base           u64 epoch, u32 state size, u32 CRC-32, state
+///     path.delta.<epoch>  deltas from the epoch's base, as frame_format frames
+///
+/// A checkpoint is on disk (flushed to the OS) when save() returns. load()
+/// maps the base and applies the deltas up to the last complete one. Only the
+/// tagged wire mode is supported. The store is not thread safe. e.g.
+///
+/// checkpoint_store store(AllDataLayout, "state");
+/// store.load(ms, allData);        // Recover at startup
+/// ...
+/// store.save(ms, allData);        // Periodically
+class checkpoint_store
+{
+public:
+    static const size_t BASE_HEADER_SIZE = 16;
+
+    /// Consolidation thresholds
+    struct limits
+    {
+        size_t deltas = 64;         // Deltas in a chain
+        double chainRatio = 1.0;    // Chain bytes relative to the state size
+    };
+
+    /// @param[in] layout - the state type layout. Must outlive the store.
+    /// @param[in] path - the checkpoint file path prefix
+    checkpoint_store(const type_layout& layout, const std::string& path_) :
+        checkpoint_store(layout, path_, limits()) {}
+
+    checkpoint_store(const type_layout& layout, const std::string& path_, const limits& limits_) :
+        differ(layout), path(path_), limit(limits_)
+    {
+        // Continue the epochs of an existing store
+        mapped_file base(path + ".base");
+        if (base.good() && base.size() >= BASE_HEADER_SIZE)
+            epoch = read_be(base.data(), 8);
+    }
+
+    /// Waits for a background consolidation.
+    ~checkpoint_store() { wait(); }
+
+    checkpoint_store(const checkpoint_store&) = delete;
+    checkpoint_store& operator=(const checkpoint_store&) = delete;
+
+    /// Delete the checkpoint files.
+    static void remove(const std::string& path)
+    {
+        mapped_file base(path + ".base");
+        if (base.good() && base.size() >= BASE_HEADER_SIZE)
+        {
+            uint64_t e = read_be(base.data(), 8);
+            std::remove(delta_name(path, e).c_str());
+            std::remove(delta_name(path, e + 1).c_str());
+        }
+        std::remove((path + ".base").c_str());
+        std::remove((path + ".base.tmp").c_str());
+    }
+
+    /// Encode the state and save a checkpoint.
+    template <class T>
+    serialize::result save(serialize& ms, T& state)
+    {
+        serialize::result r = ms.encode(state, scratch);
+        if (r.ok() && !save(scratch.data(), scratch.size()))
+            r.error = error;
+        return r;
+    }
+
+    /// Save a checkpoint of an encoded state.
+    /// @return False if the state could not be diffed or written.
+    bool save(const char* state, size_t size)
+    {
+        error = serialize::ParsingError::NONE;
+        if (!loaded)
+        {
+            // The first checkpoint is a base
+            current.assign(state, state + size);
+            loaded = true;
+            consolidate();
+            wait();
+            return good();
+        }
+
+        if (!differ.diff(current.data(), current.size(), state, size, delta))
+        {
+            error = differ.getLastError();
+            return false;
+        }
+        current.assign(state, state + size);
+
+        // A delta too large for a frame is saved as a new base
+        if (delta.size() > frame_format::MAX_PAYLOAD)
+        {
+            consolidate();
+            wait();
+            return good();
+        }
+
+        frame.clear();
+        write_frame(delta.data(), delta.size(), frame);
+        deltas.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        deltas.flush();
+        if (!deltas)
+        {
+            error = serialize::ParsingError::STREAM_ERROR;
+            return false;
+        }
+        chainCount++;
+        chainBytes += frame.size();
+        totalDeltaBytes += frame.size();
+
+        if (chainCount >= limit.deltas || static_cast<double>(chainBytes) > limit.chainRatio * static_cast<double>(size))
+            consolidate();
+        return true;
+    }
+
+    /// Load the last checkpoint and decode it.
+    template <class T>
+    serialize::result load(serialize& ms, T& state)
+    {
+        serialize::result r;
+        if (!load(scratch))
+            r.error = error;
+        else
+            r = ms.decode(scratch.data(), scratch.size(), state);
+        return r;
+    }
+
+    /// Load the last checkpoint. Later saves continue its delta chain.
+    /// @param[out] state - the encoded state
+    /// @return False if there is no valid checkpoint.
+    bool load(std::vector<char>& state)
+    {
+        wait();
+        error = serialize::ParsingError::NONE;
+
+        // On Windows, a consolidation interrupted between remove and rename leaves the temporary base
+        mapped_file base(path + ".base");
+        mapped_file temp(path + ".base.tmp");
+        mapped_file& file = base.good() ? base : temp;
+        if (!file.good() || file.size() < BASE_HEADER_SIZE)
+            return fail(serialize::ParsingError::END_OF_FILE);
+
+        const char* p = file.data();
+        uint64_t baseEpoch = read_be(p, 8);
+        size_t size = static_cast<size_t>(read_be(p + 8, 4));
+        if (file.size() - BASE_HEADER_SIZE < size || frame_crc32(p + BASE_HEADER_SIZE, size) != read_be(p + 12, 4))
+            return fail(serialize::ParsingError::INVALID_INPUT);
+
+        // Apply the base epoch's deltas, then those of a consolidation not yet completed
+        state.assign(p + BASE_HEADER_SIZE, p + BASE_HEADER_SIZE + size);
+        chainCount = 0;
+        chainBytes = 0;
+        epoch = baseEpoch;
+        std::vector<char> valid;
+        bool torn = false;
+        for (uint64_t e = baseEpoch; e <= baseEpoch + 1 && !torn; e++)
+        {
+            mapped_file chain(delta_name(path, e));
+            if (!chain.good())
+                break;
+            size_t used = 0;
+            if (!apply(chain.data(), chain.size(), state, used))
+                return false;
+            epoch = e;
+
+            // Later saves must not be appended after a torn delta
+            torn = used < chain.size();
+            if (torn)
+                valid.assign(chain.data(), chain.data() + used);
+        }
+        if (torn)
+        {
+            std::ofstream out(delta_name(path, epoch), std::ios::binary | std::ios::trunc);
+            out.write(valid.data(), static_cast<std::streamsize>(valid.size()));
+        }
+
+        current = state;
+        loaded = true;
+        deltas.close();
+        deltas.open(delta_name(path, epoch), std::ios::binary | std::ios::app);
+        if (!deltas)
+            return fail(serialize::ParsingError::STREAM_ERROR);
+        return true;
+    }
+
+    /// Start a new epoch whose base is the current state, written by a
+    /// background thread. Waits for a previous consolidation first.
+    void consolidate()
+    {
+        wait();
+        if (!loaded)
+            return;
+
+        epoch++;
+        deltas.close();
+        deltas.open(delta_name(path, epoch), std::ios::binary | std::ios::trunc);
+        if (!deltas)
+            error = serialize::ParsingError::STREAM_ERROR;
+        chainCount = 0;
+        chainBytes = 0;
+        consolidations++;
+
+        std::vector<char> snapshot(BASE_HEADER_SIZE);
+        write_be(&snapshot[0], epoch, 8);
+        write_be(&snapshot[8], current.size(), 4);
+        write_be(&snapshot[12], frame_crc32(current.data(), current.size()), 4);
+        snapshot.insert(snapshot.end(), current.begin(), current.end());
+
+        std::string basePath = path;
+        uint64_t baseEpoch = epoch;
+        writer = std::thread([this, basePath, baseEpoch, snapshot]()
+        {
+            std::string name = basePath + ".base";
+            std::string temp = name + ".tmp";
+            {
+                std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+                out.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+                out.close();
+                writeFailed = !out;
+            }
+
+            // The previous base is kept until the new one is completely written
+            if (writeFailed)
+            {
+                std::remove(temp.c_str());
+                return;
+            }
+#ifdef _WIN32
+            // Windows cannot rename over an existing file. load() falls back to the
+            // temporary base if interrupted here.
+            std::remove(name.c_str());
+#endif
+            // POSIX rename() replaces the base atomically
+            if (std::rename(temp.c_str(), name.c_str()) != 0)
+                writeFailed = true;
+
+            // Older chains are no longer needed
+            if (!writeFailed)
+            {
+                std::remove(delta_name(basePath, baseEpoch - 1).c_str());
+                if (baseEpoch >= 2)
+                    std::remove(delta_name(basePath, baseEpoch - 2).c_str());
+            }
+        });
+    }
+
+    /// Wait for a background consolidation to finish.
+    void wait()
+    {
+        if (writer.joinable())
+        {
+            writer.join();
+            if (writeFailed)
+                error = serialize::ParsingError::STREAM_ERROR;
+            writeFailed = false;
+        }
+    }
+
+    bool good() const { return error == serialize::ParsingError::NONE; }
+    serialize::ParsingError getLastError() const { return error; }
+
+    /// Get the number of deltas in the current chain.
+    size_t getChainCount() const { return chainCount; }
+
+    /// Get the bytes of all deltas saved.
+    uint64_t getDeltaBytes() const { return totalDeltaBytes; }
+
+    /// Get the number of consolidations started.
+    uint64_t getConsolidations() const { return consolidations; }
+
+private:
+    static std::string delta_name(const std::string& path, uint64_t e)
+    {
+        return path + ".delta." + std::to_string(e);
+    }
+
+    static uint64_t read_be(const char* p, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+
+    static void write_be(char* p, uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; i++)
+            p[i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+    }
+
+    bool fail(serialize::ParsingError e)
+    {
+        error = e;
+        return false;
+    }
+
+    /// Apply the complete deltas of a chain. A torn or corrupt delta and all
+    /// after it are ignored.
+    /// @param[out] pos - the size of the valid deltas
+    bool apply(const char* data, size_t size, std::vector<char>& state, size_t& pos)
+    {
+        pos = 0;
+        while (size - pos >= frame_format::HEADER_SIZE + frame_format::TRAILER_SIZE)
+        {
+            const char* p = data + pos;
+            size_t length = static_cast<size_t>(read_be(p + 2, 2));
+            size_t total = frame_format::HEADER_SIZE + length + frame_format::TRAILER_SIZE;
+            if (static_cast<uint8_t>(p[0]) != frame_format::MARKER0 || static_cast<uint8_t>(p[1]) != frame_format::MARKER1 ||
+                frame_format::lengthCheck(p + 2) != read_be(p + 4, 2) || size - pos < total ||
+                frame_crc32(p + frame_format::HEADER_SIZE, length) != read_be(p + frame_format::HEADER_SIZE + length, 4))
+                break;
+
+            if (!differ.patch(state.data(), state.size(), p + frame_format::HEADER_SIZE, length, patched))
+                return fail(differ.getLastError());
+            state.swap(patched);
+            chainCount++;
+            chainBytes += total;
+            pos += total;
+        }
+        return true;
+    }
+
+    layout_diff differ;
+    std::string path;
+    limits limit;
+    uint64_t epoch = 0;
+    bool loaded = false;
+    std::vector<char> current;
+    std::vector<char> delta;
+    std::vector<char> frame;
+    std::vector<char> patched;
+    std::vector<char> scratch;
+    std::ofstream deltas;
+    size_t chainCount = 0;
+    uint64_t chainBytes = 0;
+    uint64_t totalDeltaBytes = 0;
+    uint64_t consolidations = 0;
+    std::thread writer;
+    bool writeFailed = false;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_CHECKPOINT_H
@@ -0,0 +1,216 @@
+/// @file serialize_coalesce.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_COALESCE_H
+#define _SERIALIZE_COALESCE_H
+
+#include "serialize_core.h"
+#include <chrono>
+#include <functional>
+#include <vector>
+
+/// @brief Histogram of latencies in nanoseconds for percentile estimates.
+/// @detail Each power of two range is split into SUB_BUCKETS linear buckets, so
+/// a percentile is within 1/SUB_BUCKETS of the recorded value.
+class latency_histogram
+{
+public:
+    static const int SUB_BUCKETS = 8;
+
+    void record(uint64_t ns)
+    {
+        size_t b = bucket(ns);
+        if (buckets.size() <= b)
+            buckets.resize(b + 1);
+        buckets[b]++;
+        total++;
+    }
+
+    /// Get a latency percentile.
+    /// @param[in] p - the percentile in the range [0, 100]
+    /// @return The upper bound of the bucket holding the percentile, in nanoseconds.
+    uint64_t percentile(double p) const
+    {
+        if (total == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+        rank = rank < 1 ? 1 : rank > total ? total : rank;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); b++)
+        {
+            seen += buckets[b];
+            if (seen >= rank)
+                return upper(b);
+        }
+        return upper(buckets.size() - 1);
+    }
+
+    uint64_t getCount() const { return total; }
+
+    void clear()
+    {
+        buckets.clear();
+        total = 0;
+    }
+
+private:
+    static size_t bucket(uint64_t ns)
+    {
+        if (ns < SUB_BUCKETS)
+            return static_cast<size_t>(ns);
+        int msb = 63;
+        while ((ns >> msb) == 0)
+            msb--;
+        // msb >= 3; the SUB_BUCKETS values below the leading bit select the sub bucket
+        uint64_t sub = (ns >> (msb - 3)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>((msb - 2) * SUB_BUCKETS + sub);
+    }
+
+    static uint64_t upper(size_t b)
+    {
+        if (b < SUB_BUCKETS)
+            return b;
+        int msb = static_cast<int>(b / SUB_BUCKETS) + 2;
+        uint64_t sub = b % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (msb - 3)) - 1;
+    }
+
+    std::vector<uint64_t> buckets;
+    uint64_t total = 0;
+};
+
+/// @brief The coalescing_writer class accumulates encoded messages into one
+/// buffer and flushes them together, trading a bounded delay for fewer sends.
+/// @detail The buffer is flushed when the byte threshold or message count is
+/// reached, or when the oldest pending message reaches the delay, whichever
+/// comes first. The writer has no thread or timer; the caller's event loop
+/// calls poll() and may sleep until getDeadline(). The delay each message spent
+/// in the buffer is recorded for p50/p99 tuning. e.g.
+///
+/// coalescing_writer::limits limits;
+/// limits.delay = std::chrono::microseconds(100);
+/// coalescing_writer writer([&](const char* data, size_t size) { sock.send(data, size); }, limits);
+/// writer.write(ms, alarmLog);
+/// ...
+/// writer.poll();
+/// uint64_t p99 = writer.getLatency().percentile(99);
+class coalescing_writer
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> FlushHandler;
+    typedef std::chrono::steady_clock clock;
+
+    /// Flush thresholds
+    struct limits
+    {
+        size_t bytes = 64 * 1024;
+        size_t messages = 1024;
+        std::chrono::microseconds delay = std::chrono::microseconds(200);
+    };
+
+    /// Reasons for a flush
+    enum class Flush { BYTES, MESSAGES, DELAY, EXPLICIT, COUNT };
+
+    explicit coalescing_writer(FlushHandler handler_) : coalescing_writer(handler_, limits()) {}
+
+    coalescing_writer(FlushHandler handler_, const limits& limits_) :
+        handler(handler_), limit(limits_)
+    {
+        buffer.reserve(limit.bytes);
+        enqueued.reserve(limit.messages);
+    }
+
+    /// Pending messages are flushed.
+    ~coalescing_writer() { flush(); }
+
+    coalescing_writer(const coalescing_writer&) = delete;
+    coalescing_writer& operator=(const coalescing_writer&) = delete;
+
+    /// Encode a message and append it.
+    /// @return The encode result. Nothing is appended on error.
+    template <class T>
+    serialize::result write(serialize& ms, T& message)
+    {
+        serialize::result r = ms.encode(message, scratch);
+        if (r.ok())
+            append(scratch.data(), scratch.size());
+        return r;
+    }
+
+    /// Append an encoded message.
+    void append(const char* data, size_t size)
+    {
+        // Keep a flush within the byte threshold
+        if (!buffer.empty() && buffer.size() + size > limit.bytes)
+            flush(Flush::BYTES);
+
+        clock::time_point now = clock::now();
+        buffer.insert(buffer.end(), data, data + size);
+        enqueued.push_back(now);
+
+        if (buffer.size() >= limit.bytes)
+            flush(Flush::BYTES);
+        else if (enqueued.size() >= limit.messages)
+            flush(Flush::MESSAGES);
+        else if (now - enqueued.front() >= limit.delay)
+            flush(Flush::DELAY);
+    }
+
+    /// Flush if the oldest pending message reached the delay.
+    /// @return True if flushed.
+    bool poll()
+    {
+        if (enqueued.empty() || clock::now() < getDeadline())
+            return false;
+        flush(Flush::DELAY);
+        return true;
+    }
+
+    /// Get the time the pending messages must be flushed by, or
+    /// clock::time_point::max() if none are pending.
+    clock::time_point getDeadline() const
+    {
+        if (enqueued.empty())
+            return clock::time_point::max();
+        return enqueued.front() + limit.delay;
+    }
+
+    /// Flush pending messages now.
+    void flush() { flush(Flush::EXPLICIT); }
+
+    /// Get the delay added to each message, in nanoseconds.
+    const latency_histogram& getLatency() const { return latency; }
+
+    /// Get the number of flushes for a reason.
+    uint64_t getFlushes(Flush reason) const { return flushes[static_cast<int>(reason)]; }
+
+    size_t getPendingMessages() const { return enqueued.size(); }
+    size_t getPendingBytes() const { return buffer.size(); }
+
+private:
+    void flush(Flush reason)
+    {
+        if (enqueued.empty())
+            return;
+
+        clock::time_point now = clock::now();
+        for (const clock::time_point& t : enqueued)
+            latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - t).count()));
+        flushes[static_cast<int>(reason)]++;
+
+        handler(buffer.data(), buffer.size());
+        buffer.clear();
+        enqueued.clear();
+    }
+
+    FlushHandler handler;
+    limits limit;
+    std::vector<char> buffer;
+    std::vector<char> scratch;
+    std::vector<clock::time_point> enqueued;
+    latency_histogram latency;
+    uint64_t flushes[static_cast<int>(Flush::COUNT)] = { 0 };
+};
+
+#endif // _SERIALIZE_COALESCE_H
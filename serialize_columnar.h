@@ -0,0 +1,501 @@
+/// @file serialize_columnar.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_COLUMNAR_H
+#define _SERIALIZE_COLUMNAR_H
+
+#include "serialize_layout.h"
+#include <string>
+#include <vector>
+
+/// @brief The columnar_writer class converts encoded objects of one type into a
+/// columnar file for offline analytics.
+/// @detail Each encoded object is walked using its type_layout (no objects are
+/// created) and every leaf field is appended to its own column. Nested objects
+/// are flattened into columns named "field.nested". Column shapes are:
+///
+///     FIXED  - one scalar per row plus a validity byte per row (0 if the field
+///              was missing from an older sender)
+///     STRING - row offsets plus the string bytes (std::wstring as UTF-16LE)
+///     LIST   - row offsets plus scalar elements of container fields. Maps use
+///              "field.key" and "field.value" columns. Container elements that
+///              are user defined objects are flattened into one LIST column per
+///              scalar field; a null pointer element, or a field missing
+///              from an older sender's element, stores zeros.
+///
+/// Strings within container elements are not stored.
+///
+/// File format (little endian, arrays 64-byte aligned for mmap and vector scans):
+///
+///     header:    "SCOL", uint32 version, uint64 rows, uint32 columns, uint32 reserved
+///     directory: per column char name[64], uint8 field_kind, uint8 Shape, 
+///                uint16 width, uint32 reserved, uint64 values offset, uint64 values 
+///                size, uint64 offsets offset, uint64 validity offset
+///     arrays:    values, offsets (uint64_t[rows + 1]), validity (uint8_t[rows])
+class columnar_writer
+{
+public:
+    enum class Shape : uint8_t { FIXED, STRING, LIST, UNSUPPORTED };
+
+    explicit columnar_writer(const type_layout& layout_) : layout(layout_)
+    {
+        plan(layout, std::string(), false);
+    }
+
+    /// Append one encoded object as a row.
+    /// @param[in] data - the encoded object bytes
+    /// @param[in] size - the number of bytes
+    /// @return True if the object was added.
+    bool add(const char* data, size_t size)
+    {
+        wire_reader reader(data, size);
+        layout_walker<columnar_writer> walker(reader, *this);
+        frames.clear();
+        target = 0;
+        containerDepth = 0;
+        if (!walker.object(layout))
+        {
+            rollback();
+            error = reader.getLastError();
+            return false;
+        }
+        end_row();
+        return true;
+    }
+
+    /// Append all encoded objects within an archive stream.
+    /// @param[in] archive - the input stream of encoded objects
+    /// @return True if all objects were added.
+    bool add(std::istream& archive)
+    {
+        record_reader records(archive);
+        const char* data = nullptr;
+        size_t size = 0;
+        while (records.next(data, size))
+        {
+            if (!add(data, size))
+                return false;
+        }
+        error = records.getLastError();
+        return error == serialize::ParsingError::NONE;
+    }
+
+    /// Write the columnar file.
+    /// @param[in] os - the binary output stream
+    /// @return True if written successfully.
+    bool write(std::ostream& os)
+    {
+        std::vector<char> file;
+        size_t count = 0;
+        for (const auto& c : columns)
+            count += c.shape != Shape::UNSUPPORTED;
+
+        put(file, "SCOL", 4);
+        put_le(file, VERSION, 4);
+        put_le(file, rows, 8);
+        put_le(file, count, 4);
+        put_le(file, 0, 4);
+
+        // Column directory is patched with array offsets as they are appended
+        size_t dirPos = file.size();
+        file.resize(dirPos + count * COLUMN_SIZE);
+
+        size_t index = 0;
+        for (const auto& c : columns)
+        {
+            if (c.shape == Shape::UNSUPPORTED)
+                continue;
+            std::vector<char> entry;
+            std::vector<char> name(NAME_SIZE, 0);
+            memcpy(name.data(), c.name.data(), c.name.size() < NAME_SIZE - 1 ? c.name.size() : NAME_SIZE - 1);
+            put(entry, name.data(), NAME_SIZE);
+            put_le(entry, static_cast<uint64_t>(c.kind), 1);
+            put_le(entry, static_cast<uint64_t>(c.shape), 1);
+            put_le(entry, scalar_size(c.kind), 2);
+            put_le(entry, 0, 4);
+            put_le(entry, append(file, c.values.data(), c.values.size()), 8);
+            put_le(entry, c.values.size(), 8);
+            uint64_t offsets = 0;
+            if (c.shape != Shape::FIXED)
+            {
+                std::vector<char> le;
+                for (uint64_t o : c.offsets)
+                    put_le(le, o, 8);
+                offsets = append(file, le.data(), le.size());
+            }
+            put_le(entry, offsets, 8);
+            put_le(entry, c.shape == Shape::FIXED ? append(file, c.validity.data(), c.validity.size()) : 0, 8);
+            memcpy(&file[dirPos + index++ * COLUMN_SIZE], entry.data(), COLUMN_SIZE);
+        }
+
+        os.write(file.data(), file.size());
+        return os.good();
+    }
+
+    /// Get the number of rows added.
+    uint64_t getRows() const { return rows; }
+
+    serialize::ParsingError getLastError() const { return error; }
+
+    // layout_walker visitor interface
+    void beginObject(const type_layout& l)
+    {
+        frames.push_back(frame{ &l, target, 0 });
+    }
+
+    void endObject(const type_layout&)
+    {
+        frames.pop_back();
+    }
+
+    void beginField(const field_desc& f)
+    {
+        frame& top = frames.back();
+        target = top.base + field_offset(*top.layout, static_cast<size_t>(&f - top.layout->fields));
+        top.field = &f;
+    }
+
+    void endField(const field_desc&) {}
+
+    void missingField(const field_desc& f)
+    {
+        // Missing top-level fixed values are padded by end_row(). Within a
+        // container element, keep the element columns aligned with zero values.
+        if (containerDepth == 0)
+            return;
+        const frame& top = frames.back();
+        size_t index = static_cast<size_t>(&f - top.layout->fields);
+        size_t first = top.base + field_offset(*top.layout, index);
+        size_t last = top.base + field_offset(*top.layout, index + 1);
+        pad_list(first, last);
+    }
+
+    void scalar(field_kind kind, uint64_t bits)
+    {
+        column& c = columns[target];
+        if (c.shape == Shape::UNSUPPORTED)
+            return;
+        for (size_t i = 0; i < scalar_size(kind); i++)
+            c.values.push_back(static_cast<char>(bits >> (8 * i)));
+        if (c.shape == Shape::FIXED)
+            c.validity.push_back(1);
+    }
+
+    void string(field_kind kind, const char* data, size_t size)
+    {
+        column& c = columns[target];
+        if (c.shape != Shape::STRING)
+            return;
+        if (kind == field_kind::CSTRING)
+            size = strnlen(data, size);
+        if (kind == field_kind::WSTRING)
+        {
+            // Wire characters are big endian
+            for (size_t i = 0; i + 1 < size; i += 2)
+            {
+                c.values.push_back(data[i + 1]);
+                c.values.push_back(data[i]);
+            }
+        }
+        else
+        {
+            c.values.insert(c.values.end(), data, data + size);
+        }
+    }
+
+    void beginContainer(const field_desc&, size_t) { containerDepth++; }
+    void endContainer(const field_desc&) { containerDepth--; }
+
+    void beginElement(size_t)
+    {
+        frame& top = frames.back();
+        target = top.base + field_offset(*top.layout, static_cast<size_t>(top.field - top.layout->fields));
+    }
+
+    void mapValue()
+    {
+        target++;
+    }
+
+    void nullObject()
+    {
+        // Keep the element columns aligned with zero values
+        const type_layout* element = frames.back().field->object;
+        pad_list(target, target + leaf_count(*element));
+    }
+
+private:
+    static const uint32_t VERSION = 1;
+    static const size_t NAME_SIZE = 64;
+    static const size_t COLUMN_SIZE = NAME_SIZE + 8 + 4 * 8;
+    static const size_t ALIGNMENT = 64;
+
+    struct column
+    {
+        std::string name;
+        field_kind kind;
+        Shape shape;
+        std::vector<char> values;
+        std::vector<uint64_t> offsets;
+        std::vector<char> validity;
+    };
+
+    struct frame
+    {
+        const type_layout* layout;
+        size_t base;                // Column index of the first field
+        const field_desc* field;    // Current field
+    };
+
+    /// Create the columns for each leaf field in layout order.
+    void plan(const type_layout& l, const std::string& prefix, bool list)
+    {
+        for (size_t i = 0; i < l.count; i++)
+        {
+            const field_desc& f = l.fields[i];
+            std::string name = prefix + f.name;
+            if (f.kind == field_kind::OBJECT)
+            {
+                plan(*f.object, name + ".", list);
+            }
+            else if (is_scalar(f.kind))
+            {
+                add_column(name, f.kind, list ? Shape::LIST : Shape::FIXED);
+            }
+            else if (f.kind == field_kind::STRING || f.kind == field_kind::CSTRING || f.kind == field_kind::WSTRING)
+            {
+                add_column(name, f.kind, list ? Shape::UNSUPPORTED : Shape::STRING);
+            }
+            else
+            {
+                bool nested = list;
+                if (f.kind == field_kind::MAP)
+                {
+                    add_column(name + ".key", f.key, nested ? Shape::UNSUPPORTED : Shape::LIST);
+                    name += ".value";
+                }
+                if (is_scalar(f.element))
+                    add_column(name, f.element, nested ? Shape::UNSUPPORTED : Shape::LIST);
+                else if (nested)
+                    plan_unsupported(*f.object, name + ".");
+                else
+                    plan(*f.object, name + ".", true);
+            }
+        }
+    }
+
+    void plan_unsupported(const type_layout& l, const std::string& prefix)
+    {
+        for (size_t i = 0; i < leaf_count(l); i++)
+            add_column(prefix + std::to_string(i), field_kind::UINT8, Shape::UNSUPPORTED);
+    }
+
+    void add_column(const std::string& name, field_kind kind, Shape shape)
+    {
+        columns.push_back(column{ name, kind, shape, {}, { 0 }, {} });
+    }
+
+    /// Get the number of columns used by a layout.
+    static size_t leaf_count(const type_layout& l)
+    {
+        return field_offset(l, l.count);
+    }
+
+    /// Get the column offset of field index within a layout.
+    static size_t field_offset(const type_layout& l, size_t index)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < index; i++)
+        {
+            const field_desc& f = l.fields[i];
+            if (f.kind == field_kind::OBJECT)
+                n += leaf_count(*f.object);
+            else if (is_scalar(f.kind) || f.kind == field_kind::STRING || f.kind == field_kind::CSTRING || f.kind == field_kind::WSTRING)
+                n += 1;
+            else
+                n += (f.kind == field_kind::MAP ? 1 : 0) + (is_scalar(f.element) ? 1 : leaf_count(*f.object));
+        }
+        return n;
+    }
+
+    /// Append a zero element to the LIST columns in [first, last).
+    void pad_list(size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            column& c = columns[i];
+            if (c.shape == Shape::LIST)
+                c.values.resize(c.values.size() + scalar_size(c.kind), 0);
+        }
+    }
+
+    /// Complete the row: pad missing fixed values and record variable offsets.
+    void end_row()
+    {
+        rows++;
+        for (auto& c : columns)
+        {
+            if (c.shape == Shape::FIXED)
+            {
+                if (c.validity.size() < rows)
+                {
+                    c.values.resize(c.values.size() + scalar_size(c.kind), 0);
+                    c.validity.push_back(0);
+                }
+            }
+            else
+            {
+                c.offsets.push_back(c.values.size() / (c.shape == Shape::LIST ? scalar_size(c.kind) : 1));
+            }
+        }
+    }
+
+    /// Discard a partially added row.
+    void rollback()
+    {
+        for (auto& c : columns)
+        {
+            if (c.shape == Shape::FIXED)
+            {
+                c.values.resize(rows * scalar_size(c.kind));
+                c.validity.resize(rows);
+            }
+            else
+            {
+                c.values.resize(c.offsets.back() * (c.shape == Shape::LIST ? scalar_size(c.kind) : 1));
+            }
+        }
+    }
+
+    static void put(std::vector<char>& out, const char* data, size_t size)
+    {
+        out.insert(out.end(), data, data + size);
+    }
+
+    static void put_le(std::vector<char>& out, uint64_t value, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+            out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+
+    /// Append an aligned array to the file.
+    /// @return The array file offset.
+    static uint64_t append(std::vector<char>& file, const char* data, size_t size)
+    {
+        file.resize((file.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, 0);
+        uint64_t offset = file.size();
+        put(file, data, size);
+        return offset;
+    }
+
+    const type_layout& layout;
+    std::vector<column> columns;
+    std::vector<frame> frames;
+    size_t target = 0;
+    size_t containerDepth = 0;
+    uint64_t rows = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+
+    friend class columnar_reader;
+};
+
+/// @brief The columnar_reader class loads a file written by columnar_writer.
+/// @detail The file is read into one aligned buffer; column arrays point into
+/// it directly. Values are little endian.
+class columnar_reader
+{
+public:
+    struct column
+    {
+        std::string name;
+        field_kind kind;
+        columnar_writer::Shape shape;
+        size_t width;               // Scalar size in bytes
+        const char* values;
+        uint64_t valuesSize;        // In bytes
+        const uint64_t* offsets;    // STRING and LIST rows + 1 offsets, else nullptr
+        const uint8_t* validity;    // FIXED row validity, else nullptr
+    };
+
+    /// Load a columnar file.
+    /// @param[in] is - the binary input stream
+    /// @return True if the file is valid.
+    bool read(std::istream& is)
+    {
+        columns.clear();
+        is.seekg(0, std::ios_base::end);
+        std::streamoff end = is.tellg();
+        if (end < 0)
+            return false;
+        size_t size = static_cast<size_t>(end);
+        is.seekg(0, std::ios_base::beg);
+        storage.assign((size + 7) / 8, 0);
+        char* file = reinterpret_cast<char*>(storage.data());
+        is.read(file, size);
+        if (!is.good() || size < HEADER_SIZE || memcmp(file, "SCOL", 4) != 0)
+            return false;
+
+        rows = get_le(file + 8, 8);
+        size_t count = static_cast<size_t>(get_le(file + 16, 4));
+        if (HEADER_SIZE + count * columnar_writer::COLUMN_SIZE > size)
+            return false;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const char* p = file + HEADER_SIZE + i * columnar_writer::COLUMN_SIZE;
+            column c;
+            c.name.assign(p, strnlen(p, columnar_writer::NAME_SIZE));
+            p += columnar_writer::NAME_SIZE;
+            c.kind = static_cast<field_kind>(p[0]);
+            c.shape = static_cast<columnar_writer::Shape>(p[1]);
+            c.width = static_cast<size_t>(get_le(p + 2, 2));
+            uint64_t values = get_le(p + 8, 8);
+            c.valuesSize = get_le(p + 16, 8);
+            uint64_t offsets = get_le(p + 24, 8);
+            uint64_t validity = get_le(p + 32, 8);
+            // The offsets array is accessed in place, so it must also be aligned
+            if (values > size || c.valuesSize > size - values ||
+                (offsets && (offsets % alignof(uint64_t) != 0 || offsets > size || (size - offsets) / 8 <= rows)) ||
+                (validity && (validity > size || size - validity < rows)))
+                return false;
+            c.values = file + values;
+            c.offsets = offsets ? reinterpret_cast<const uint64_t*>(file + offsets) : nullptr;
+            c.validity = validity ? reinterpret_cast<const uint8_t*>(file + validity) : nullptr;
+            columns.push_back(c);
+        }
+        return true;
+    }
+
+    uint64_t getRows() const { return rows; }
+    const std::vector<column>& getColumns() const { return columns; }
+
+    /// Find a column by name.
+    /// @return The column or nullptr if not found.
+    const column* find(const std::string& name) const
+    {
+        for (const auto& c : columns)
+        {
+            if (c.name == name)
+                return &c;
+        }
+        return nullptr;
+    }
+
+private:
+    static const size_t HEADER_SIZE = 24;
+
+    static uint64_t get_le(const char* p, size_t size)
+    {
+        uint64_t v = 0;
+        for (size_t i = size; i-- > 0;)
+            v = (v << 8) | static_cast<uint8_t>(p[i]);
+        return v;
+    }
+
+    std::vector<uint64_t> storage;
+    std::vector<column> columns;
+    uint64_t rows = 0;
+};
+
+#endif // _SERIALIZE_COLUMNAR_H
@@ -0,0 +1,1281 @@
+/// @file serialize_core.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_CORE_H
+#define _SERIALIZE_CORE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <typeinfo>
+#include <chrono>
+#include <limits>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class serialize;
+
+/// Container serialization is implemented by specializations of serialize_container
+/// in the opt-in container headers: serialize_vector.h, serialize_list.h, 
+/// serialize_map.h and serialize_set.h. A specialization defines supported = true 
+/// and static write() and read() functions. serialize.h includes all of them.
+template <typename C>
+struct serialize_container
+{
+    static const bool supported = false;
+};
+
+/// @brief The serialize class binary serializes and deserializes C++ objects.
+/// @detail Each class need to implement the serialize::I abstract interface
+/// to allow binary serialization to any stream. A default constructor is required
+/// for the serialized object. Most container elements can be stored by value or 
+/// by pointer. C++ containers supported are:
+/// 
+///     vector      (serialize_vector.h)
+///     list        (serialize_list.h)
+///     map         (serialize_map.h)
+///     set         (serialize_set.h)
+///     string
+///     wstring
+///     char[]
+///
+/// Include serialize.h for all containers, or serialize_core.h and only the 
+/// container headers used to reduce compile time.
+///
+/// Always check the input stream or output stream to ensure no errors
+/// before using data. e.g.
+///
+/// if (ss.good())
+///     // Do something with input or output data
+///
+/// This serialization class is not thread safe and a serialie instance should 
+/// only be accessed from a single task.
+/// 
+/// The serialize class support receiving objects that have more or less data fields 
+/// that what is currenting being parsed. If more data is received after parsing an
+/// object, the extra data is discard. If less data is received, the parsing of the 
+/// extra data fields does not occur. This supports the protocol changing by adding new
+/// data elements to an object. Once the protocol is released at a particular version,
+/// new data elements can be added but existing ones cannot be removed/changed. 
+class serialize
+{
+public:
+    /// @brief Abstract interface that all serialized user defined classes inherit.
+    class I
+    {
+    public:
+        /// Inheriting class implements the write function. Write each
+        /// class member to the ostream. Write in the same order as read().
+        /// Each level within the hierarchy must implement. Ensure base 
+        /// write() implementation is called if necessary. 
+        /// @param[in] ms - the message serialize instance
+        /// @param[in] is - the input stream
+        /// @return The input stream
+        virtual std::ostream& write(serialize& ms, std::ostream& os) = 0;
+
+        /// Inheriting class implements the read function. Read each
+        /// class member to the ostream. Read in the same order as write().
+        /// Each level within the hierarchy must implement. Ensure base 
+        /// read() implementation is called if necessary. 
+        /// @param[in] ms - the message serialize instance
+        /// @param[in] is - the input stream
+        /// @return The input stream
+        virtual std::istream& read(serialize& ms, std::istream& is) = 0;
+    };
+
+    enum class Type 
+    {
+        UNKNOWN = 0,
+        LITERAL = 1,
+        STRING = 8,
+        WSTRING = 9,
+        VECTOR = 20,
+        MAP = 21,
+        LIST = 22,
+        SET = 23,
+        ENDIAN = 30,
+        USER_DEFINED = 31,
+    };
+
+    enum class ParsingError
+    {
+        NONE,
+        TYPE_MISMATCH,
+        STREAM_ERROR,
+        STRING_TOO_LONG,
+        CONTAINER_TOO_MANY,
+        INVALID_INPUT,
+        END_OF_FILE,
+        DEPTH_EXCEEDED,
+        BUDGET_EXCEEDED
+    };
+
+    /// Encodings of the fields within a user defined object.
+    enum class WireMode : uint8_t
+    {
+        TAGGED,             // A type byte precedes each field (default)
+        UNTAGGED            // No type bytes except USER_DEFINED. Both peers must 
+                            // share the same layout, e.g. agreed by schema_handshake.
+    };
+
+    /// Categories of encoded bytes reported to an IWireHandler.
+    enum class WireBytes
+    {
+        TYPE_TAG,           // Type byte prepended to a field
+        LENGTH_PREFIX,      // String length or container element count
+        NULL_FLAG,          // notNULL flag preceding a pointer container element
+        USER_DEFINED_SIZE,  // Size of a user defined object
+        PAYLOAD,            // Data values
+        SKIPPED             // Received data not parsed by the receiver
+    };
+
+    /// @brief Abstract interface to observe how encoded bytes are spent.
+    /// @detail Register with setWireHandler(). Each write() or read() reports 
+    /// the bytes encoded or decoded by category and attributes them to the
+    /// current field of the innermost user defined object. 
+    class IWireHandler
+    {
+    public:
+        virtual ~IWireHandler() = default;
+
+        /// Called before a user defined object's fields are written or read.
+        /// @param[in] typeId - the user defined object type
+        virtual void wireBegin(const std::type_info& typeId) = 0;
+
+        /// Called after a user defined object's fields are written or read.
+        virtual void wireEnd() = 0;
+
+        /// Called when a new field of the current user defined object starts. 
+        /// Container elements do not start a new field.
+        virtual void wireField() = 0;
+
+        /// Called for each group of bytes written or read. 
+        /// @param[in] category - what the bytes are used for
+        /// @param[in] size - the number of bytes
+        virtual void wireBytes(WireBytes category, size_t size) = 0;
+    };
+
+    /// Outcome of encode() or decode(). On failure, offset is the byte offset 
+    /// where the first error occurred. On success, offset is the number of bytes 
+    /// encoded or decoded.
+    struct result
+    {
+        ParsingError error = ParsingError::NONE;
+        size_t offset = 0;
+
+        bool ok() const { return error == ParsingError::NONE; }
+    };
+
+    /// Resource limits for decoding one message, everything read by one top-level 
+    /// read() or decode(). A zero limit is unlimited. 
+    struct decode_budget
+    {
+        size_t bytes = 0;               // Bytes read
+        size_t elements = 0;            // Container elements
+        size_t allocations = 0;         // Objects created with new by pointer containers
+        std::chrono::microseconds time = std::chrono::microseconds::zero();  // Wall time
+    };
+
+    /// @brief Stream buffer over memory used by encode() and decode().
+    /// @detail Reads from a caller's fixed buffer or writes to a growable vector.
+    /// Unlike std::stringstream no copy of the data is made and the current byte
+    /// offset is always available, even after a stream error.
+    class memory_streambuf : public std::streambuf
+    {
+    public:
+        /// Read from a buffer. The buffer must outlive the stream buffer.
+        memory_streambuf(const char* data, size_t size)
+        {
+            char* p = const_cast<char*>(data);
+            setg(p, p, p + size);
+        }
+
+        /// Write to a vector. The vector is resized to the bytes written by finish().
+        explicit memory_streambuf(std::vector<char>& out_) : out(&out_)
+        {
+            out->resize(out->capacity() < 256 ? 256 : out->capacity());
+            setp(out->data(), out->data() + out->size());
+        }
+
+        /// Get the current read or write byte offset.
+        size_t position() const { return out ? pptr() - pbase() : gptr() - eback(); }
+
+        /// Trim the output vector to the bytes written.
+        void finish()
+        {
+            if (out)
+                out->resize(written());
+        }
+
+    protected:
+        virtual int_type overflow(int_type c) override
+        {
+            if (traits_type::eq_int_type(c, traits_type::eof()))
+                return traits_type::not_eof(c);
+
+            // Double the output vector keeping the current position
+            size_t pos = position();
+            high = written();
+            out->resize(out->size() * 2);
+            set_put(pos);
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+            return c;
+        }
+
+        virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+        {
+            size_t end = out ? written() : static_cast<size_t>(egptr() - eback());
+            off_type base = dir == std::ios_base::beg ? 0 : 
+                dir == std::ios_base::cur ? static_cast<off_type>(position()) : static_cast<off_type>(end);
+            return seekpos(pos_type(base + off), which);
+        }
+
+        virtual pos_type seekpos(pos_type pos, std::ios_base::openmode) override
+        {
+            off_type p = static_cast<off_type>(pos);
+            size_t end = out ? written() : static_cast<size_t>(egptr() - eback());
+            if (p < 0 || static_cast<size_t>(p) > end)
+                return pos_type(off_type(-1));
+
+            if (out)
+            {
+                high = end;
+                set_put(static_cast<size_t>(p));
+            }
+            else
+            {
+                setg(eback(), eback() + p, egptr());
+            }
+            return pos;
+        }
+
+    private:
+        /// Bytes written including any written past a backward seek
+        size_t written() const
+        {
+            size_t pos = position();
+            return pos > high ? pos : high;
+        }
+
+        void set_put(size_t pos)
+        {
+            setp(out->data(), out->data() + out->size());
+            // pbump() takes an int so advance in steps
+            while (pos > 0)
+            {
+                int step = pos > 0x40000000 ? 0x40000000 : static_cast<int>(pos);
+                pbump(step);
+                pos -= step;
+            }
+        }
+
+        std::vector<char>* out = nullptr;
+        size_t high = 0;
+    };
+
+    // Maximum sizes allowed by parser
+    static const uint16_t MAX_STRING_SIZE = 256;
+    static const uint16_t MAX_CONTAINER_SIZE = 200;
+    static const uint16_t MAX_OBJECT_DEPTH = 32;
+
+    // Keep wchar_t serialize size consistent on any platform
+    static const size_t WCHAR_SIZE = 2;
+
+    serialize() = default;
+    ~serialize() = default;
+
+    /// Returns true if little endian.
+    /// @return Returns true if little endian. 
+    bool LE()
+    {        
+        const static  int n = 1;
+        const static  bool le= (* (char *)&n == 1);
+        return le;
+    }
+    
+    /// Read endian from stream.
+    /// @param[in] istream - input stream
+    /// @return Return true if little endian.
+    std::istream& readEndian(std::istream& is, bool& littleEndian)
+    {
+        if (read_type(is, Type::ENDIAN))
+        {
+            is.read((char*) &littleEndian, sizeof(littleEndian));
+        }
+        return is;
+    }
+    
+    /// Write current CPU endian to stream.
+    /// @param[in] ostream - output stream
+    void writeEndian(std::ostream& os)
+    {
+        bool littleEndian = LE();        
+        write_type(os, Type::ENDIAN);
+        os.write((const char*) &littleEndian, sizeof(littleEndian));
+    }
+    
+    /// Read a user defined object implementing the serialize:I interface from a stream.
+    /// Normally the send and reciever object is the same size. However, if a newer version of 
+    /// the object is introduced on one side the sizes will differ. If received object is smaller 
+    /// than sent object, the extra data in the sent object is discarded.
+    /// @param[in] is - the input stream
+    /// @param[in] t_ - the object to read 
+    /// @return The output stream
+    std::istream& read (std::istream& is, I* t_)
+    {
+        budget_scope budgetScope(*this);
+        if (check_stop_parse(is))
+            return is;
+
+        if (check_pointer(is, t_) && check_depth(is) && check_budget(is))
+        {
+            if (read_type(is, Type::USER_DEFINED))
+            {
+                uint16_t size = 0;
+                std::streampos startPos = is.tellg();
+
+                read_overhead(is, size, WireBytes::USER_DEFINED_SIZE);
+
+                object_scope scope(*this, typeid(*t_));
+
+                // Save the stop parsing position to prevent parsing overrun
+                push_stop_parse_pos(startPos + std::streampos(size));
+
+                t_->read(*this, is);
+
+                pop_stop_parse_pos();
+
+                if (is.good())
+                {
+                    std::streampos endPos = is.tellg();
+                    uint16_t rcvdSize = static_cast<uint16_t>(endPos - startPos);
+
+                    // Did sender send a larger object than what receiver parsed? 
+                    if (rcvdSize < size)
+                    {
+                        // Skip over the extra received data
+                        uint16_t seekOffset = size - rcvdSize; 
+                        is.seekg(seekOffset, std::ios_base::cur);
+                        wire_bytes(WireBytes::SKIPPED, seekOffset);
+                    }
+                }
+                return is;
+            }
+        }
+        return is;
+    }
+
+    /// Read a str::string from a stream. 
+    /// @param[in] os - the input stream
+    /// @param[in] s - the string to read 
+    /// @return The input stream
+    std::istream& read (std::istream& is, std::string& s)
+    {
+        budget_scope budgetScope(*this);
+        if (check_stop_parse(is))
+            return is;
+
+        if (read_type(is, Type::STRING))
+        {
+            uint16_t size = 0;
+            read_overhead(is, size, WireBytes::LENGTH_PREFIX);
+            if (check_stream(is) && check_slength(is, size))
+            {
+                s.resize(size);
+                parseStatus(typeid(s), s.size());
+                read_internal(is, const_cast<char*>(s.c_str()), size, true);
+            }
+        }
+        return  is;
+    }
+    
+    /// Read a str::wstring from a stream.
+    /// @param[in] os - the input stream
+    /// @param[in] s - the string to read
+    /// @return The input stream
+    std::istream& read (std::istream& is, std::wstring& s)
+    {
+        budget_scope budgetScope(*this);
+        if (check_stop_parse(is))
+            return is;
+
+        if (read_type(is, Type::WSTRING))
+        {
+            uint16_t size = 0;
+            read_overhead(is, size, WireBytes::LENGTH_PREFIX);
+            if (check_stream(is) && check_slength(is, size))
+            {
+                s.resize(size);
+                parseStatus(typeid(s), s.size());
+                for (uint16_t ii = 0; ii < size; ii++)
+                {
+                    wchar_t c = 0;
+                    // Low order WCHAR_SIZE bytes of the wchar_t
+                    int offset = LE() ? 0 : sizeof(wchar_t) - WCHAR_SIZE;
+                    read_internal(is, reinterpret_cast<char*>(&c) + offset, WCHAR_SIZE);
+                    s[ii] = c;
+                }
+            }
+        }
+        return  is;
+    }
+
+    /// Read a character string from a stream. 
+    /// @param[in] is - the input stream
+    /// @param[in] str - the character string to read into
+    /// @return The input stream
+    std::istream& read (std::istream& is, char* str)
+    {
+        budget_scope budgetScope(*this);
+        if (check_stop_parse(is))
+            return is;
+
+        if (read_type(is, Type::STRING))
+        {
+            uint16_t size = 0;
+            read_overhead(is, size, WireBytes::LENGTH_PREFIX);
+            if (check_stream(is) && check_slength(is, size))
+            {
+                if (check_pointer(is, str))
+                {
+                    parseStatus(typeid(str), size);
+                    read_internal(is, str, size, true);
+                }
+            }
+        }
+        return  is;
+    }
+
+    /// Read a character string into a fixed size buffer, e.g. a char[N] field.
+    /// A string longer than the buffer fails with ParsingError::STRING_TOO_LONG
+    /// and nothing is written to the buffer.
+    /// @param[in] is - the input stream
+    /// @param[in] str - the buffer to read into
+    /// @param[in] capacity - the buffer size in bytes, including the terminator
+    /// @return The input stream
+    std::istream& read (std::istream& is, char* str, size_t capacity)
+    {
+        budget_scope budgetScope(*this);
+        if (check_stop_parse(is))
+            return is;
+
+        if (read_type(is, Type::STRING))
+        {
+            uint16_t size = 0;
+            read_overhead(is, size, WireBytes::LENGTH_PREFIX);
+            if (check_stream(is) && check_slength(is, size) && check_pointer(is, str))
+            {
+                if (size > capacity)
+                {
+                    raiseError(ParsingError::STRING_TOO_LONG, __LINE__, __FILE__);
+                    is.setstate(std::ios::failbit);
+                    return is;
+                }
+                parseStatus(typeid(str), size);
+                read_internal(is, str, size, true);
+
+                // The sender's terminator is not trusted
+                if (is.good())
+                    str[size - 1] = 0;
+            }
+        }
+        return  is;
+    }
+    
+    
+    /// Write a user defined object implementing the serialize:I 
+    /// interface to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] t_ - the object to write 
+    /// @return The output stream
+    std::ostream& write (std::ostream& os, I* t_)
+    {
+        if (check_pointer(os, t_))
+        {
+            uint16_t elementSize = 0;
+
+            write_type(os, Type::USER_DEFINED);
+            std::streampos elementSizePos = os.tellp();
+            write_overhead(os, elementSize, WireBytes::USER_DEFINED_SIZE);
+
+            {
+                object_scope scope(*this, typeid(*t_));
+
+                // Write user defined object
+                t_->write(*this, os);
+            }
+
+            if (os.good())
+            {
+                // Write user defined object size into stream. The size bytes 
+                // were already reported to the wire handler above.
+                IWireHandler* handler = wire_handler;
+                wire_handler = nullptr;
+                std::streampos currentPos = os.tellp();
+                os.seekp(elementSizePos);
+                elementSize = static_cast<uint16_t>(currentPos - elementSizePos);
+                write(os, elementSize, false);
+                os.seekp(currentPos);
+                wire_handler = handler;
+            }
+            return os;
+        }
+        return os;
+    }
+
+    /// Write a const std::string to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] s - the string to write
+    /// @return The output stream
+    std::ostream& write(std::ostream& os, const std::string& s)
+    {
+        uint16_t size = static_cast<uint16_t>(s.size());
+        write_type(os, Type::STRING);
+        write_overhead(os, size, WireBytes::LENGTH_PREFIX);
+        if (check_stream(os) && check_slength(os, size))
+        {
+            write_internal(os, s.c_str(), size, true);
+        }
+        return os;
+    }
+
+    /// Write a std::string to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] s - the string to write
+    /// @return The output stream
+    std::ostream& write(std::ostream& os, std::string& s)
+    {
+        return write(os, static_cast<const std::string&>(s));
+    }
+
+    /// Write a const str::wstring to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] s - the string to write
+    /// @return The output stream
+    std::ostream& write (std::ostream& os, const std::wstring& s)
+    {
+        uint16_t size = static_cast<uint16_t>(s.size());
+        write_type(os, Type::WSTRING);
+        write_overhead(os, size, WireBytes::LENGTH_PREFIX);
+        if (check_stream(os) && check_slength(os, size))
+        {
+            for (uint16_t ii = 0; ii < size; ii++)
+            {
+                wchar_t c = s[ii];
+                // Low order WCHAR_SIZE bytes of the wchar_t
+                int offset = LE() ? 0 : sizeof(wchar_t) - WCHAR_SIZE;
+                write_internal(os, reinterpret_cast<char*>(&c) + offset, WCHAR_SIZE);
+            }
+        }
+        return os;
+    }
+
+    /// Write a str::wstring to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] s - the string to write
+    /// @return The output stream
+    std::ostream& write (std::ostream& os, std::wstring& s)
+    {
+        return write(os, static_cast<const std::wstring&>(s));
+    }
+
+    /// Write a character string to a stream. 
+    /// @param[in] os - the output stream
+    /// @param[in] str - the character string to write. 
+    /// @return The output stream
+    std::ostream& write(std::ostream& os, char* str)
+    {
+        return write(os, static_cast<const char*>(str));
+    }
+    
+    /// Write a const character string to a stream. 
+    /// @param[in] os - the output stream
+    /// @param[in] str - the character string to write. 
+    /// @return The output stream
+    std::ostream& write (std::ostream& os, const char* str)
+    {
+        if (check_pointer(os, str))
+        {
+            uint16_t size = static_cast<uint16_t>(strlen(str)) + 1;
+            write_type(os, Type::STRING);
+            write_overhead(os, size, WireBytes::LENGTH_PREFIX);
+            if (check_stream(os) && check_slength(os, size))
+            {
+                write_internal (os, str, size, true);
+            }
+        }
+        return os;
+    }
+    
+ 
+    /// Read an object from a stream. 
+    /// @param[in] is - the input stream
+    /// @param[in] t_ - the object to read into
+    /// @return The input stream
+    template<typename T>
+    std::istream& read(std::istream& is, T &t_, bool readPrependedType = true)
+    {
+        budget_scope budgetScope(*this);
+        return read_value(is, t_, readPrependedType, std::integral_constant<bool, serialize_container<T>::supported>());
+    }
+
+    /// Write an object to a stream. 
+    /// @param[in] os - the output stream
+    /// @param[in] t_ - the object to write 
+    /// @return The output stream
+    template<typename T>
+    std::ostream& write(std::ostream& os, T &t_, bool prependType = true)
+    {
+        return write_value(os, t_, prependType, std::integral_constant<bool, serialize_container<T>::supported>());
+    }
+
+    /// Encode an object into a buffer. Stream state does not need to be checked.
+    /// @param[in] t_ - the object to write
+    /// @param[out] out - the encoded bytes. Existing contents are replaced.
+    /// @return The first error and its byte offset, or the number of bytes encoded.
+    template<typename T>
+    result encode(T& t_, std::vector<char>& out)
+    {
+        memory_streambuf buf(out);
+        std::ostream os(&buf);
+        begin_result(buf);
+        write(os, t_);
+        buf.finish();
+        return end_result(os, buf);
+    }
+
+    /// Decode an object from a buffer. Stream state does not need to be checked.
+    /// @param[in] data - the encoded bytes
+    /// @param[in] size - the number of bytes 
+    /// @param[out] t_ - the object to read into
+    /// @return The first error and its byte offset, or the number of bytes decoded.
+    template<typename T>
+    result decode(const char* data, size_t size, T& t_)
+    {
+        memory_streambuf buf(data, size);
+        std::istream is(&buf);
+        begin_result(buf);
+        read(is, t_);
+        return end_result(is, buf);
+    }
+
+    /// Encode consecutive objects into a buffer using one stream.
+    /// @param[in] items - the objects to write
+    /// @param[in] count - the number of objects
+    /// @param[out] out - the encoded bytes. Existing contents are replaced.
+    /// @return The first error and its byte offset, or the number of bytes encoded.
+    template<typename T>
+    result encode(T* items, size_t count, std::vector<char>& out)
+    {
+        memory_streambuf buf(out);
+        std::ostream os(&buf);
+        begin_result(buf);
+        for (size_t i = 0; i < count && os.good(); i++)
+            write(os, items[i]);
+        buf.finish();
+        return end_result(os, buf);
+    }
+
+    /// Decode consecutive objects from a buffer using one stream.
+    /// @param[in] data - the encoded bytes
+    /// @param[in] size - the number of bytes 
+    /// @param[out] items - the objects to read into
+    /// @param[in] count - the number of objects
+    /// @return The first error and its byte offset, or the number of bytes decoded.
+    template<typename T>
+    result decode(const char* data, size_t size, T* items, size_t count)
+    {
+        memory_streambuf buf(data, size);
+        std::istream is(&buf);
+        begin_result(buf);
+        for (size_t i = 0; i < count && is.good(); i++)
+            read(is, items[i]);
+        return end_result(is, buf);
+    }
+
+    typedef void (*ErrorHandler)(ParsingError error, int line, const char* file);
+    void setErrorHandler(ErrorHandler error_handler_)
+    {
+        error_handler = error_handler_;
+    }
+
+    ParsingError getLastError() const { return lastError; }
+    void clearLastError() { lastError = ParsingError::NONE; }
+
+    typedef void (*ParseHandler)(const std::type_info& typeId, size_t size);
+    void setParseHandler(ParseHandler parse_handler_)
+    {
+        parse_handler = parse_handler_;
+    }
+
+    void setWireHandler(IWireHandler* wire_handler_)
+    {
+        wire_handler = wire_handler_;
+    }
+
+    /// Set the per-message decode budget. A message exceeding any limit fails
+    /// with ParsingError::BUDGET_EXCEEDED, before allocating for the element or
+    /// object over the limit. Bytes are checked per value read. Time is checked
+    /// at object, container and allocation boundaries. With no budget set, the
+    /// cost is a branch per value, container and read() call.
+    /// @param[in] budget_ - the limits. A default decode_budget is unlimited.
+    void setDecodeBudget(const decode_budget& budget_)
+    {
+        budget = budget_;
+        budgetEnabled = budget.bytes || budget.elements || budget.allocations || budget.time.count();
+    }
+
+    /// Get the resources used by the current or last decoded message. Only 
+    /// counted while a decode budget is set.
+    const decode_budget& getDecodeUsage() const { return budgetUsed; }
+
+    /// Set the wire mode used by write() and expected by read(). The user defined
+    /// object type and size are always encoded, so unparsed extra fields are 
+    /// still skipped.
+    void setWireMode(WireMode wireMode_)
+    {
+        wireMode = wireMode_;
+    }
+
+    WireMode getWireMode() const { return wireMode; }
+
+    /// Set the maximum nesting depth of user defined objects accepted by read().
+    /// Deeper input fails with ParsingError::DEPTH_EXCEEDED.
+    void setMaxDepth(uint16_t maxDepth_)
+    {
+        maxDepth = maxDepth_;
+    }
+
+    /// Enable canonical encoding. Equal objects then encode to equal bytes:
+    /// pointer sets are written in order of their element encodings, negative
+    /// zero is written as zero and every NaN as the same quiet NaN.
+    void setCanonical(bool canonical_)
+    {
+        canonical = canonical_;
+    }
+
+    bool getCanonical() const { return canonical; }
+
+private:
+    template <typename C>
+    friend struct serialize_container;
+
+    /// Read a built-in data type or user defined object from a stream.
+    template<typename T>
+    std::istream& read_value(std::istream& is, T &t_, bool readPrependedType, std::false_type)
+    {
+        static_assert(!std::is_class<T>::value || std::is_base_of<serialize::I, T>::value,
+            "Type T must be derived from serialize::I or be a supported container. Include the container header (e.g. serialize_list.h).");
+
+        static_assert(!(std::is_pointer<T>::value && std::is_arithmetic<typename std::remove_pointer<T>::type>::value),
+            "T cannot be a pointer to a built-in data type");
+
+        if (check_stop_parse(is))
+            return is;
+
+        // Is T a built-in data type (e.g. float, int, ...)?
+        if (std::is_class<T>::value == false)
+        {
+            // Is T is not a pointer type
+            if (std::is_pointer<T>::value == false)
+            {
+                if (readPrependedType)
+                {
+                    if(!read_type(is, Type::LITERAL))
+                    {
+                        return is;
+                    }
+                }
+
+                if (readPrependedType)
+                    parseStatus(typeid(t_));
+                read_internal(is, (char*)&t_, sizeof (t_));
+                return is;
+            }
+            else
+            {
+                // Can't read pointers to built-in type
+                raiseError(ParsingError::INVALID_INPUT, __LINE__, __FILE__);
+                is.setstate(std::ios::failbit);
+                return is;
+            }
+        }
+        // Else T is a user defined data type (e.g. MyData)
+        else
+        {
+            parseStatus(typeid(t_));
+            read(is, (serialize::I*)&t_);
+            return is;
+        }
+    }
+
+    /// Read a container from a stream.
+    template<typename T>
+    std::istream& read_value(std::istream& is, T &t_, bool, std::true_type)
+    {
+        return serialize_container<T>::read(*this, is, t_);
+    }
+
+    /// Write a built-in data type or user defined object to a stream.
+    template<typename T>
+    std::ostream& write_value(std::ostream& os, T &t_, bool prependType, std::false_type)
+    {
+        static_assert(!std::is_class<T>::value || std::is_base_of<serialize::I, T>::value,
+            "Type T must be derived from serialize::I or be a supported container. Include the container header (e.g. serialize_list.h).");
+
+        static_assert(!(std::is_pointer<T>::value && std::is_arithmetic<typename std::remove_pointer<T>::type>::value),
+            "T cannot be a pointer to a built-in data type");
+
+        // Is T type a built-in data type (e.g. float, int, ...)?
+        if (std::is_class<T>::value == false)
+        {    
+            // Is T is not a pointer type
+            if (std::is_pointer<T>::value == false)
+            {
+                if (prependType)
+                {
+                    write_type(os, Type::LITERAL);
+                }
+                return write_scalar(os, t_, std::is_floating_point<T>());
+            }
+            else
+            {
+                // Can't write pointers to built-in type
+                raiseError(ParsingError::INVALID_INPUT, __LINE__, __FILE__);
+                os.setstate(std::ios::failbit);
+                return os;
+            }
+        }
+        // Else T type is a user defined data type (e.g. MyData)
+        else
+        {     
+            return write(os, (serialize::I*)&t_);
+        }
+    }
+
+    template<typename T>
+    std::ostream& write_scalar(std::ostream& os, const T& t_, std::false_type)
+    {
+        return write_internal(os, (const char*)&t_, sizeof(t_));
+    }
+
+    /// Write a floating point value, normalized if canonical.
+    template<typename T>
+    std::ostream& write_scalar(std::ostream& os, const T& t_, std::true_type)
+    {
+        T value = t_;
+        if (canonical)
+        {
+            if (value == 0)
+                value = 0;
+            else if (value != value)
+                value = std::numeric_limits<T>::quiet_NaN();
+        }
+        return write_internal(os, (const char*)&value, sizeof(value));
+    }
+
+    /// Write a container to a stream.
+    template<typename T>
+    std::ostream& write_value(std::ostream& os, T &t_, bool, std::true_type)
+    {
+        return serialize_container<T>::write(*this, os, t_);
+    }
+
+    /// Read from stream and place into caller's character buffer
+    /// @param[in] is - input stream
+    /// @param[out] p - the input bytes read
+    /// @param[in] size - number of bytes to read
+    /// @param[in] no_swap - true means no endian byte swapping (for char arrays mostly). 
+    ///        false means perform endian byte swapping as necessary. 
+    /// @return The input stream.
+    std::istream& read_internal(std::istream& is, char* p, uint32_t size, bool no_swap = false)
+    {
+        if (check_stop_parse(is))
+        {
+            return is;
+        }
+
+        if (!check_pointer(is, p))
+        {
+            return is;
+        }
+        if (budgetEnabled)
+        {
+            // Only the byte limit is checked per value; the clock is read at boundaries
+            budgetUsed.bytes += size;
+            if (budget.bytes && budgetUsed.bytes > budget.bytes)
+            {
+                budget_exceeded(is);
+                return is;
+            }
+        }
+        wire_bytes(wireCategory, size);
+        if (LE() && !no_swap)
+        {
+            // If little endian, read as little endian
+            for (int i = size - 1; i >= 0; --i)
+            {
+                is.read(p + i, 1);
+            }
+        }
+        else
+        {
+            // Read as big endian
+            is.read(p, size);
+        }
+
+        return  is;
+    }
+
+    /// Write to stream the bytes specified 
+    /// @param[in] os - output stream
+    /// @param[out] p - the output bytes to write
+    /// @param[in] size - number of bytes to write 
+    /// @param[in] no_swap - true means no endian byte swapping (for char arrays mostly). 
+    ///        false means perform endian byte swapping as necessary. 
+    /// @return The output stream
+    std::ostream& write_internal(std::ostream& os, const char* p, uint32_t size, bool no_swap = false)
+    {
+        if (!check_pointer(os, p))
+        {
+            return os;
+        }
+        wire_bytes(wireCategory, size);
+        if (LE() && !no_swap)
+        {
+            // If little endian, write as little endian
+            for (int i = size - 1; i >= 0; --i)
+            {
+                os.write(p + i, 1);
+            }
+        }
+        else
+        {
+            // Write as big endian
+            os.write(p, size);
+        }
+        return  os;
+    }
+
+    // Used to stop parsing early if not enough data to continue. One entry
+    // per nested user defined object being read.
+    std::vector<std::streampos> stopParsePosStack;
+    uint16_t maxDepth = MAX_OBJECT_DEPTH;
+    WireMode wireMode = WireMode::TAGGED;
+    bool canonical = false;
+
+    decode_budget budget;
+    decode_budget budgetUsed;
+    bool budgetEnabled = false;
+    std::chrono::steady_clock::time_point budgetStart;
+    int budgetDepth = 0;
+
+    ErrorHandler error_handler = nullptr;
+    ParsingError lastError = ParsingError::NONE;
+    void raiseError(ParsingError error, int line, const char* file)
+    {
+        lastError = error;
+        if (resultBuf && resultError.ok())
+        {
+            resultError.error = error;
+            resultError.offset = resultBuf->position();
+        }
+        if (error_handler)
+            error_handler(error, line, file);
+    }
+
+    // First error of the current encode() or decode()
+    memory_streambuf* resultBuf = nullptr;
+    result resultError;
+
+    void begin_result(memory_streambuf& buf)
+    {
+        resultBuf = &buf;
+        resultError = result();
+    }
+
+    result end_result(std::ios& stream, memory_streambuf& buf)
+    {
+        result r = resultError;
+        resultBuf = nullptr;
+        if (r.ok())
+        {
+            // A stream failure without a parsing error
+            if (stream.fail())
+                r.error = ParsingError::STREAM_ERROR;
+            r.offset = buf.position();
+        }
+        return r;
+    }
+
+    ParseHandler parse_handler = nullptr;
+    void parseStatus(const std::type_info& typeId, size_t size = 0)
+    {
+        if (parse_handler)
+            parse_handler(typeId, size);
+    }
+
+    IWireHandler* wire_handler = nullptr;
+    WireBytes wireCategory = WireBytes::PAYLOAD;
+    int elementDepth = 0;
+    void wire_bytes(WireBytes category, size_t size)
+    {
+        if (wire_handler)
+            wire_handler->wireBytes(category, size);
+    }
+
+    void wire_field()
+    {
+        if (wire_handler && elementDepth == 0)
+            wire_handler->wireField();
+    }
+
+    /// Marks a user defined object's fields for the wire handler
+    struct object_scope
+    {
+        object_scope(serialize& ms_, const std::type_info& typeId) : ms(ms_), depth(ms_.elementDepth)
+        {
+            ms.elementDepth = 0;
+            if (ms.wire_handler)
+                ms.wire_handler->wireBegin(typeId);
+        }
+        ~object_scope()
+        {
+            if (ms.wire_handler)
+                ms.wire_handler->wireEnd();
+            ms.elementDepth = depth;
+        }
+        serialize& ms;
+        int depth;
+    };
+
+    /// Starts a new message budget at the outermost read(), whether a top-level
+    /// object, container or value, and covers everything read within it. Does
+    /// nothing while no budget is set.
+    struct budget_scope
+    {
+        explicit budget_scope(serialize& ms_) : ms(ms_), active(ms_.budgetEnabled)
+        {
+            if (active && ms.budgetDepth++ == 0)
+                ms.begin_budget();
+        }
+        ~budget_scope()
+        {
+            if (active)
+                ms.budgetDepth--;
+        }
+        serialize& ms;
+        bool active;
+    };
+
+    /// Marks container elements so they are not reported as new fields
+    struct element_scope
+    {
+        explicit element_scope(serialize& ms_) : ms(ms_) { ms.elementDepth++; }
+        ~element_scope() { ms.elementDepth--; }
+        serialize& ms;
+    };
+
+    /// Write a length, null flag or user defined size to a stream.
+    /// @param[in] os - the output stream
+    /// @param[in] value - the value to write without a prepended type
+    /// @param[in] category - the wire category reported for the value bytes
+    template <typename T>
+    void write_overhead(std::ostream& os, T value, WireBytes category)
+    {
+        wireCategory = category;
+        write(os, value, false);
+        wireCategory = WireBytes::PAYLOAD;
+    }
+
+    /// Read a length, null flag or user defined size from a stream.
+    /// @param[in] is - the input stream
+    /// @param[out] value - the value to read without a prepended type
+    /// @param[in] category - the wire category reported for the value bytes
+    template <typename T>
+    void read_overhead(std::istream& is, T& value, WireBytes category)
+    {
+        wireCategory = category;
+        read(is, value, false);
+        wireCategory = WireBytes::PAYLOAD;
+    }
+
+    void write_type(std::ostream& os, Type type_)
+    {
+        uint8_t type = static_cast<uint8_t>(type_);
+        wire_field();
+        if (wireMode == WireMode::UNTAGGED && type_ != Type::USER_DEFINED)
+            return;
+        wireCategory = WireBytes::TYPE_TAG;
+        write_internal(os, (const char*) &type, sizeof(type));
+        wireCategory = WireBytes::PAYLOAD;
+    }
+
+    bool read_type(std::istream& is, Type type_)
+    {
+        if (wireMode == WireMode::UNTAGGED && type_ != Type::USER_DEFINED)
+        {
+            wire_field();
+            return true;
+        }
+
+        std::istream::int_type peek = is.peek();
+        Type type = static_cast<Type>(peek);
+        if (type == type_)
+        {
+            uint8_t typeByte = 0;
+            wire_field();
+            wireCategory = WireBytes::TYPE_TAG;
+            read_internal(is, (char*) &typeByte, sizeof(typeByte));
+            wireCategory = WireBytes::PAYLOAD;
+            return true;
+        }
+        else
+        {
+            // Distinguish truncated input from an unexpected type
+            bool end = std::istream::traits_type::eq_int_type(peek, std::istream::traits_type::eof());
+            raiseError(end ? ParsingError::END_OF_FILE : ParsingError::TYPE_MISMATCH, __LINE__, __FILE__);
+            is.setstate(std::ios::failbit);
+            return false;
+        }
+    }
+
+    bool check_stream(std::ios& stream)
+    {
+        if (!stream.good())
+        {
+            raiseError(ParsingError::STREAM_ERROR, __LINE__, __FILE__);
+            stream.setstate(std::ios::failbit);
+        }
+        return stream.good();
+    }
+
+    bool check_slength(std::ios& stream, int stringSize)
+    {
+        bool sizeOk = stringSize <= MAX_STRING_SIZE;
+        if (!sizeOk)
+        {
+            raiseError(ParsingError::STRING_TOO_LONG, __LINE__, __FILE__);
+            stream.setstate(std::ios::failbit);
+        }
+        if (stringSize == 0)
+            return false;
+        return sizeOk;
+    }
+
+    bool check_container_size(std::ios& stream, int containerSize)
+    {
+        bool sizeOk = containerSize <= MAX_CONTAINER_SIZE;
+        if (!sizeOk)
+        {
+            raiseError(ParsingError::CONTAINER_TOO_MANY, __LINE__, __FILE__);
+            stream.setstate(std::ios::failbit);
+        }
+        return sizeOk;
+    }
+
+    bool check_pointer(std::ios& stream, const void* ptr)
+    {
+        if (!ptr)
+        {
+            raiseError(ParsingError::INVALID_INPUT, __LINE__, __FILE__);
+            stream.setstate(std::ios::failbit);
+        }
+        return ptr != NULL;
+    }
+
+    bool check_depth(std::ios& stream)
+    {
+        bool depthOk = stopParsePosStack.size() < maxDepth;
+        if (!depthOk)
+        {
+            raiseError(ParsingError::DEPTH_EXCEEDED, __LINE__, __FILE__);
+            stream.setstate(std::ios::failbit);
+        }
+        return depthOk;
+    }
+
+    void begin_budget()
+    {
+        budgetUsed = decode_budget();
+        budgetStart = std::chrono::steady_clock::now();
+    }
+
+    /// Count container elements against the decode budget.
+    bool charge_elements(std::ios& stream, size_t count)
+    {
+        if (!budgetEnabled)
+            return true;
+        budgetUsed.elements += count;
+        return check_budget(stream);
+    }
+
+    /// Count an object allocation against the decode budget.
+    bool charge_allocation(std::ios& stream)
+    {
+        if (!budgetEnabled)
+            return true;
+        budgetUsed.allocations++;
+        return check_budget(stream);
+    }
+
+    bool check_budget(std::ios& stream)
+    {
+        if (!budgetEnabled)
+            return true;
+
+        // Time is checked at object, container and allocation boundaries
+        budgetUsed.time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - budgetStart);
+
+        bool budgetOk = (!budget.bytes || budgetUsed.bytes <= budget.bytes) &&
+            (!budget.elements || budgetUsed.elements <= budget.elements) &&
+            (!budget.allocations || budgetUsed.allocations <= budget.allocations) &&
+            (!budget.time.count() || budgetUsed.time <= budget.time);
+        if (!budgetOk)
+            budget_exceeded(stream);
+        return budgetOk;
+    }
+
+    void budget_exceeded(std::ios& stream)
+    {
+        raiseError(ParsingError::BUDGET_EXCEEDED, __LINE__, __FILE__);
+        stream.setstate(std::ios::failbit);
+    }
+
+    void push_stop_parse_pos(std::streampos stopParsePos)
+    {
+        stopParsePosStack.push_back(stopParsePos);
+    }
+
+    std::streampos pop_stop_parse_pos()
+    {
+        std::streampos stopParsePos = stopParsePosStack.back();
+        stopParsePosStack.pop_back();
+        return stopParsePos;
+    }
+
+    bool check_stop_parse(std::istream& is)
+    {
+        if (is.eof())
+        {
+            raiseError(ParsingError::END_OF_FILE, __LINE__, __FILE__);
+            return true;
+        }
+        if (stopParsePosStack.size() > 0)
+        {
+            std::streampos stopParsePos = stopParsePosStack.back();
+            if (is.tellg() >= stopParsePos)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // _SERIALIZE_CORE_H
@@ -0,0 +1,395 @@
+/// @file serialize_diff.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_DIFF_H
+#define _SERIALIZE_DIFF_H
+
+#include "serialize_layout.h"
+#include <vector>
+
+/// @brief The layout_diff class computes structural deltas between two encodings
+/// of a message type and applies them, without decoding into objects.
+/// @detail A delta is a list of edits per object. Unchanged fields are not sent.
+/// A changed nested object is diffed recursively, a changed container is spliced
+/// (remove and insert elements at an index) and any other changed field is
+/// replaced. Fields appended or removed by another message version are supported.
+/// e.g.
+///
+/// layout_diff differ(AllDataLayout);
+/// differ.diff(oldBytes, oldSize, newBytes, newSize, delta);    // Leader
+/// differ.patch(oldBytes, oldSize, delta.data(), delta.size(), newBytes);  // Follower
+///
+/// Delta encoding, big endian:
+///
+///     object := u16 edit count, edits in increasing field order
+///     edit   := u16 field index, u8 op, body
+///     REPLACE:  u16 size, field bytes
+///     OBJECT:   object (nested object delta)
+///     SPLICE:   u16 index, u16 remove count, u16 insert count, u16 size, element bytes
+///     TRUNCATE: no body; the field and all following fields are removed
+///
+/// Field index layout.count is any extra data after the last known field. Only
+/// the tagged wire mode is supported.
+class layout_diff
+{
+public:
+    explicit layout_diff(const type_layout& layout_) : layout(layout_) {}
+
+    /// Compute the delta from an old encoding to a new encoding.
+    /// @param[in] oldData - the old encoded object
+    /// @param[in] oldSize - the old size
+    /// @param[in] newData - the new encoded object
+    /// @param[in] newSize - the new size
+    /// @param[out] delta - the delta. Existing contents are replaced.
+    /// @return True if both encodings were parsed.
+    bool diff(const char* oldData, size_t oldSize, const char* newData, size_t newSize, std::vector<char>& delta)
+    {
+        error = serialize::ParsingError::NONE;
+        delta.clear();
+        return diff_object(layout, oldData, oldSize, newData, newSize, delta, 0);
+    }
+
+    /// Apply a delta to an old encoding.
+    /// @param[in] oldData - the old encoded object the delta was computed from
+    /// @param[in] oldSize - the old size
+    /// @param[in] delta - the delta
+    /// @param[in] deltaSize - the delta size
+    /// @param[out] out - the new encoded object. Existing contents are replaced.
+    /// @return True if the delta was applied.
+    bool patch(const char* oldData, size_t oldSize, const char* delta, size_t deltaSize, std::vector<char>& out)
+    {
+        error = serialize::ParsingError::NONE;
+        out.clear();
+        wire_reader reader(delta, deltaSize);
+        if (patch_object(layout, oldData, oldSize, reader, out, 0) && reader.remaining() != 0)
+            fail(serialize::ParsingError::INVALID_INPUT);
+        if (!reader.good())
+            fail(reader.getLastError());
+        return error == serialize::ParsingError::NONE;
+    }
+
+    serialize::ParsingError getLastError() const { return error; }
+
+private:
+    enum class Op : uint8_t { REPLACE, OBJECT, SPLICE, TRUNCATE };
+
+    /// Byte offsets of a field within its object encoding
+    struct field_span
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t elements = 0;                // Container elements start
+        std::vector<size_t> elementBegins;
+    };
+
+    /// Records the spans of the top level fields and their container elements.
+    struct span_visitor
+    {
+        explicit span_visitor(wire_reader& reader_) : reader(reader_) {}
+
+        void beginObject(const type_layout&) { objectDepth++; }
+        void endObject(const type_layout&) { objectDepth--; }
+        void beginField(const field_desc&)
+        {
+            if (objectDepth == 1)
+            {
+                fields.push_back(field_span());
+                fields.back().begin = reader.offset();
+            }
+        }
+        void endField(const field_desc&)
+        {
+            if (objectDepth == 1)
+                fields.back().end = reader.offset();
+        }
+        void missingField(const field_desc&) {}
+        void scalar(field_kind, uint64_t) {}
+        void string(field_kind, const char*, size_t) {}
+        void beginContainer(const field_desc&, size_t)
+        {
+            if (objectDepth == 1)
+                fields.back().elements = reader.offset();
+        }
+        void endContainer(const field_desc&) {}
+        void beginElement(size_t)
+        {
+            if (objectDepth == 1)
+                fields.back().elementBegins.push_back(reader.offset());
+        }
+        void mapValue() {}
+        void nullObject() {}
+
+        wire_reader& reader;
+        std::vector<field_span> fields;
+        int objectDepth = 0;
+    };
+
+    void fail(serialize::ParsingError e)
+    {
+        if (error == serialize::ParsingError::NONE)
+            error = e;
+    }
+
+    /// Split an encoded object into field spans. If every field is present, a
+    /// final span holds any extra data from a newer version.
+    bool split(const type_layout& objectLayout, const char* data, size_t size, std::vector<field_span>& fields, int depth)
+    {
+        wire_reader reader(data, size);
+        span_visitor visitor(reader);
+        layout_walker<span_visitor> walker(reader, visitor);
+        walker.setMaxDepth(static_cast<uint16_t>(serialize::MAX_OBJECT_DEPTH - depth));
+        if (!walker.object(objectLayout))
+        {
+            fail(reader.getLastError());
+            return false;
+        }
+        if (reader.offset() != size)
+        {
+            fail(serialize::ParsingError::INVALID_INPUT);
+            return false;
+        }
+
+        fields.swap(visitor.fields);
+        if (fields.size() == objectLayout.count)
+        {
+            field_span extra;
+            extra.begin = fields.empty() ? HEADER_SIZE : fields.back().end;
+            extra.end = size;
+            fields.push_back(extra);
+        }
+        return true;
+    }
+
+    static void put_u16(std::vector<char>& out, size_t value)
+    {
+        out.push_back(static_cast<char>(value >> 8));
+        out.push_back(static_cast<char>(value));
+    }
+
+    static void put_edit(std::vector<char>& out, size_t field, Op op)
+    {
+        put_u16(out, field);
+        out.push_back(static_cast<char>(op));
+    }
+
+    static bool same(const char* a, const field_span& sa, const char* b, const field_span& sb)
+    {
+        return sa.end - sa.begin == sb.end - sb.begin && memcmp(a + sa.begin, b + sb.begin, sa.end - sa.begin) == 0;
+    }
+
+    static void put_replace(std::vector<char>& out, size_t field, const char* data, const field_span& span)
+    {
+        put_edit(out, field, Op::REPLACE);
+        put_u16(out, span.end - span.begin);
+        out.insert(out.end(), data + span.begin, data + span.end);
+    }
+
+    bool diff_object(const type_layout& objectLayout, const char* oldData, size_t oldSize,
+        const char* newData, size_t newSize, std::vector<char>& out, int depth)
+    {
+        std::vector<field_span> oldFields, newFields;
+        if (!split(objectLayout, oldData, oldSize, oldFields, depth) ||
+            !split(objectLayout, newData, newSize, newFields, depth))
+            return false;
+
+        size_t countPos = out.size();
+        size_t edits = 0;
+        put_u16(out, 0);
+
+        size_t common = oldFields.size() < newFields.size() ? oldFields.size() : newFields.size();
+        for (size_t i = 0; i < common; i++)
+        {
+            const field_span& o = oldFields[i];
+            const field_span& n = newFields[i];
+            if (same(oldData, o, newData, n))
+                continue;
+            edits++;
+
+            field_kind kind = i < objectLayout.count ? objectLayout.fields[i].kind : field_kind::STRING;
+            if (kind == field_kind::OBJECT)
+            {
+                // Keep the nested delta only if smaller than the replacement
+                size_t start = out.size();
+                put_edit(out, i, Op::OBJECT);
+                if (!diff_object(*objectLayout.fields[i].object, oldData + o.begin, o.end - o.begin,
+                    newData + n.begin, n.end - n.begin, out, depth + 1))
+                    return false;
+                if (out.size() - start > n.end - n.begin + 5)
+                {
+                    out.resize(start);
+                    put_replace(out, i, newData, n);
+                }
+            }
+            else if (kind == field_kind::VECTOR || kind == field_kind::LIST ||
+                kind == field_kind::SET || kind == field_kind::MAP)
+            {
+                put_splice(out, i, oldData, o, newData, n);
+            }
+            else
+            {
+                put_replace(out, i, newData, n);
+            }
+        }
+
+        // Fields appended or removed by another version
+        for (size_t i = common; i < newFields.size(); i++, edits++)
+            put_replace(out, i, newData, newFields[i]);
+        if (oldFields.size() > newFields.size())
+        {
+            put_edit(out, newFields.size(), Op::TRUNCATE);
+            edits++;
+        }
+
+        out[countPos] = static_cast<char>(edits >> 8);
+        out[countPos + 1] = static_cast<char>(edits);
+        return true;
+    }
+
+    /// Replace the changed middle elements, keeping the common prefix and suffix.
+    static void put_splice(std::vector<char>& out, size_t field, const char* oldData, const field_span& o,
+        const char* newData, const field_span& n)
+    {
+        size_t oldCount = o.elementBegins.size(), newCount = n.elementBegins.size();
+        auto element = [](const field_span& s, size_t i)
+        {
+            field_span e;
+            e.begin = s.elementBegins[i];
+            e.end = i + 1 < s.elementBegins.size() ? s.elementBegins[i + 1] : s.end;
+            return e;
+        };
+
+        size_t prefix = 0;
+        while (prefix < oldCount && prefix < newCount &&
+            same(oldData, element(o, prefix), newData, element(n, prefix)))
+            prefix++;
+        size_t suffix = 0;
+        while (suffix < oldCount - prefix && suffix < newCount - prefix &&
+            same(oldData, element(o, oldCount - 1 - suffix), newData, element(n, newCount - 1 - suffix)))
+            suffix++;
+
+        size_t insert = newCount - prefix - suffix;
+        size_t begin = prefix < newCount ? n.elementBegins[prefix] : n.end;
+        size_t end = newCount - suffix < newCount ? n.elementBegins[newCount - suffix] : n.end;
+
+        put_edit(out, field, Op::SPLICE);
+        put_u16(out, prefix);
+        put_u16(out, oldCount - prefix - suffix);
+        put_u16(out, insert);
+        put_u16(out, end - begin);
+        out.insert(out.end(), newData + begin, newData + end);
+    }
+
+    bool patch_object(const type_layout& objectLayout, const char* oldData, size_t oldSize,
+        wire_reader& delta, std::vector<char>& out, int depth)
+    {
+        std::vector<field_span> fields;
+        if (!split(objectLayout, oldData, oldSize, fields, depth))
+            return false;
+
+        size_t start = out.size();
+        out.insert(out.end(), oldData, oldData + HEADER_SIZE);
+
+        size_t next = 0;
+        uint16_t edits = delta.readU16();
+        for (uint16_t e = 0; e < edits && delta.good(); e++)
+        {
+            size_t field = delta.readU16();
+            Op op = static_cast<Op>(delta.readU8());
+            if (!delta.good())
+                break;
+            // Appended fields follow the last old field without gaps
+            if (field < next || field > (next > fields.size() ? next : fields.size()) || field > objectLayout.count)
+            {
+                fail(serialize::ParsingError::INVALID_INPUT);
+                return false;
+            }
+
+            // Unchanged fields before the edit
+            for (; next < field; next++)
+                out.insert(out.end(), oldData + fields[next].begin, oldData + fields[next].end);
+
+            const bool exists = field < fields.size();
+            const field_kind kind = field < objectLayout.count ? objectLayout.fields[field].kind : field_kind::STRING;
+            if (op == Op::REPLACE)
+            {
+                uint16_t size = delta.readU16();
+                const char* bytes = delta.readBytes(size);
+                if (bytes)
+                    out.insert(out.end(), bytes, bytes + size);
+            }
+            else if (op == Op::OBJECT && exists && kind == field_kind::OBJECT)
+            {
+                if (!patch_object(*objectLayout.fields[field].object, oldData + fields[field].begin,
+                    fields[field].end - fields[field].begin, delta, out, depth + 1))
+                    return false;
+            }
+            else if (op == Op::SPLICE && exists && (kind == field_kind::VECTOR || kind == field_kind::LIST ||
+                kind == field_kind::SET || kind == field_kind::MAP))
+            {
+                if (!apply_splice(oldData, fields[field], delta, out))
+                    return false;
+            }
+            else if (op == Op::TRUNCATE)
+            {
+                next = fields.size();
+                break;
+            }
+            else
+            {
+                fail(serialize::ParsingError::INVALID_INPUT);
+                return false;
+            }
+            next = field + 1;
+        }
+        if (!delta.good())
+            return false;
+
+        for (; next < fields.size(); next++)
+            out.insert(out.end(), oldData + fields[next].begin, oldData + fields[next].end);
+
+        // Size is measured from the start of the size field
+        size_t size = out.size() - start - 1;
+        if (size > 0xFFFF)
+        {
+            fail(serialize::ParsingError::INVALID_INPUT);
+            return false;
+        }
+        out[start + 1] = static_cast<char>(size >> 8);
+        out[start + 2] = static_cast<char>(size);
+        return true;
+    }
+
+    bool apply_splice(const char* oldData, const field_span& field, wire_reader& delta, std::vector<char>& out)
+    {
+        size_t index = delta.readU16();
+        size_t remove = delta.readU16();
+        size_t insert = delta.readU16();
+        size_t size = delta.readU16();
+        const char* bytes = delta.readBytes(size);
+        size_t count = field.elementBegins.size();
+        if (!bytes || index + remove > count || count - remove + insert > 0xFFFF)
+        {
+            fail(delta.good() ? serialize::ParsingError::INVALID_INPUT : delta.getLastError());
+            return false;
+        }
+
+        auto begin = [&](size_t i) { return i < count ? field.elementBegins[i] : field.end; };
+
+        // Container type and the new element count
+        out.insert(out.end(), oldData + field.begin, oldData + field.elements - 2);
+        put_u16(out, count - remove + insert);
+        out.insert(out.end(), oldData + field.elements, oldData + begin(index));
+        out.insert(out.end(), bytes, bytes + size);
+        out.insert(out.end(), oldData + begin(index + remove), oldData + field.end);
+        return true;
+    }
+
+    // USER_DEFINED type and size
+    static const size_t HEADER_SIZE = 3;
+
+    const type_layout& layout;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_DIFF_H
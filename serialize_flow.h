@@ -0,0 +1,384 @@
+/// @file serialize_flow.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_FLOW_H
+#define _SERIALIZE_FLOW_H
+
+#include "serialize_core.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/// @brief A fixed number of reusable encode buffers.
+/// @detail Buffers keep their capacity between uses, so steady state encoding
+/// does not allocate. A buffer grown past the buffer size by a large message is
+/// trimmed when released, keeping the pool memory bounded. The pool is not
+/// thread safe.
+class buffer_pool
+{
+public:
+    /// @param[in] count - the number of buffers
+    /// @param[in] bufferSize - the bytes reserved for each buffer
+    buffer_pool(size_t count, size_t bufferSize_) : buffers(count), bufferSize(bufferSize_)
+    {
+        available.reserve(count);
+        for (std::vector<char>& b : buffers)
+        {
+            b.reserve(bufferSize);
+            available.push_back(&b);
+        }
+    }
+
+    buffer_pool(const buffer_pool&) = delete;
+    buffer_pool& operator=(const buffer_pool&) = delete;
+
+    /// Get a free buffer.
+    /// @return The buffer, or nullptr if all buffers are in use.
+    std::vector<char>* acquire()
+    {
+        if (available.empty())
+            return nullptr;
+        std::vector<char>* b = available.back();
+        available.pop_back();
+        return b;
+    }
+
+    /// Return a buffer from acquire() to the pool.
+    void release(std::vector<char>* buffer)
+    {
+        buffer->clear();
+        if (buffer->capacity() > bufferSize)
+        {
+            std::vector<char>().swap(*buffer);
+            buffer->reserve(bufferSize);
+        }
+        available.push_back(buffer);
+    }
+
+    size_t getCount() const { return buffers.size(); }
+    size_t getAvailable() const { return available.size(); }
+    size_t getBufferSize() const { return bufferSize; }
+
+private:
+    std::vector<std::vector<char>> buffers;
+    std::vector<std::vector<char>*> available;
+    size_t bufferSize;
+};
+
+/// Credits granted by a receiver to a sender.
+struct credit_grant
+{
+    static const size_t SIZE = 8;
+
+    uint32_t bytes = 0;
+    uint32_t messages = 0;
+
+    /// Write the grant message: uint32 bytes, uint32 messages, big endian.
+    void write(std::vector<char>& out) const
+    {
+        out.clear();
+        put(out, bytes);
+        put(out, messages);
+    }
+
+    /// Read a grant message.
+    /// @return True if the message is a grant.
+    bool read(const char* data, size_t size)
+    {
+        if (size != SIZE)
+            return false;
+        bytes = load(data);
+        messages = load(data + 4);
+        return true;
+    }
+
+private:
+    static void put(std::vector<char>& out, uint32_t value)
+    {
+        for (int i = 3; i >= 0; i--)
+            out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+
+    static uint32_t load(const char* p)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+};
+
+/// @brief The credit_receiver class decides when to return credits to the
+/// sender of a message stream.
+/// @detail The receiver starts by granting its whole window. Credits are
+/// returned only for messages the application has consumed, not merely
+/// received, so a slow consumer slows the sender. Credits are batched until half
+/// of either window is consumed to limit grant traffic. e.g.
+///
+/// credit_receiver receiver(256 * 1024, 64);
+/// receiver.getInitialGrant().write(grant);    // Send to sender
+/// ...
+/// ms.decode(data, size, alarmLog);
+/// process(alarmLog);
+/// if (receiver.consume(size))
+///     receiver.takeGrant().write(grant);      // Send to sender
+///
+/// The byte window must be at least the largest message size.
+class credit_receiver
+{
+public:
+    /// @param[in] windowBytes - the maximum bytes in flight or unconsumed
+    /// @param[in] windowMessages - the maximum messages in flight or unconsumed
+    credit_receiver(uint32_t windowBytes_, uint32_t windowMessages_) :
+        windowBytes(windowBytes_), windowMessages(windowMessages_) {}
+
+    /// Get the credits to grant when the stream starts.
+    credit_grant getInitialGrant() const
+    {
+        credit_grant g;
+        g.bytes = windowBytes;
+        g.messages = windowMessages;
+        return g;
+    }
+
+    /// Record a message consumed by the application.
+    /// @param[in] size - the message size in bytes
+    /// @return True if a grant should be sent now.
+    bool consume(size_t size)
+    {
+        consumed.bytes += static_cast<uint32_t>(size);
+        consumed.messages++;
+        return consumed.bytes >= windowBytes / 2 || consumed.messages >= windowMessages / 2;
+    }
+
+    /// Take the credits consumed since the last grant.
+    credit_grant takeGrant()
+    {
+        credit_grant g = consumed;
+        consumed = credit_grant();
+        return g;
+    }
+
+private:
+    uint32_t windowBytes;
+    uint32_t windowMessages;
+    credit_grant consumed;
+};
+
+/// @brief The credit_sender class sends encoded messages only while the
+/// receiver has granted byte and message credits.
+/// @detail Messages are encoded into buffers from a bounded pool and queued
+/// until credits arrive. When every buffer is in use the policy decides:
+///
+///     BLOCK - wait for a buffer. Grants must arrive on another thread.
+///     DROP - discard the new message.
+///     COALESCE - the new message replaces the newest queued message, for
+///                streams where the latest value supersedes earlier ones.
+///
+/// Memory stays at the pool size however far the receiver falls behind. The
+/// send handler is called with the sender unlocked and must finish with the
+/// bytes before returning. The sender is thread safe; each producer thread uses
+/// its own serialize instance. e.g.
+///
+/// credit_sender sender([&](const char* data, size_t size) { sock.send(data, size); },
+///     16, 1024, credit_sender::Policy::DROP);
+/// sender.write(ms, alarmLog);
+/// ...
+/// credit_grant g;
+/// if (g.read(data, size))                     // Received from receiver
+///     sender.grant(g);
+class credit_sender
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> SendHandler;
+
+    /// Action when every pool buffer is in use
+    enum class Policy { BLOCK, DROP, COALESCE };
+
+    /// Outcome of a write
+    enum class Status { ACCEPTED, COALESCED, DROPPED, FAILED };
+
+    /// @param[in] handler - sends one encoded message
+    /// @param[in] buffers - the number of pool buffers
+    /// @param[in] bufferSize - the bytes reserved for each pool buffer
+    /// @param[in] policy - the action when every buffer is in use
+    credit_sender(SendHandler handler_, size_t buffers, size_t bufferSize, Policy policy_) :
+        handler(handler_), pool(buffers, bufferSize), policy(policy_) {}
+
+    /// Blocked writers must have returned before destruction.
+    ~credit_sender() { close(); }
+
+    credit_sender(const credit_sender&) = delete;
+    credit_sender& operator=(const credit_sender&) = delete;
+
+    /// Encode a message and send it, or queue it until credits arrive.
+    /// @return ACCEPTED if sent or queued, COALESCED if it replaced a queued
+    /// message, DROPPED if discarded or closed, or FAILED if the encode failed
+    /// (see getLastError()).
+    template <class T>
+    Status write(serialize& ms, T& message)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<char>* buffer = pool.acquire();
+        Status status = Status::ACCEPTED;
+        if (buffer == nullptr && policy == Policy::BLOCK)
+        {
+            stalls++;
+            while (!closed && (buffer = pool.acquire()) == nullptr)
+                released.wait(lock);
+        }
+        else if (buffer == nullptr && policy == Policy::COALESCE && !queue.empty())
+        {
+            // Take over the newest queued buffer
+            buffer = queue.back();
+            queue.pop_back();
+            status = Status::COALESCED;
+        }
+        if (closed || buffer == nullptr)
+        {
+            if (buffer != nullptr)
+                pool.release(buffer);
+            dropped++;
+            return Status::DROPPED;
+        }
+
+        lock.unlock();
+        serialize::result r = ms.encode(message, *buffer);
+        lock.lock();
+
+        if (!r.ok())
+        {
+            // A replaced message was overwritten by the failed encode
+            if (status == Status::COALESCED)
+                dropped++;
+            lastError = r.error;
+            pool.release(buffer);
+            released.notify_one();
+            return Status::FAILED;
+        }
+        if (status == Status::COALESCED)
+            coalesced++;
+        queue.push_back(buffer);
+        pump(lock);
+        return status;
+    }
+
+    /// Add credits granted by the receiver and send queued messages they allow.
+    void grant(const credit_grant& g)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        creditBytes += g.bytes;
+        creditMessages += g.messages;
+        pump(lock);
+    }
+
+    /// Wake blocked writers and drop later writes. Queued messages are kept.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        released.notify_all();
+    }
+
+    serialize::ParsingError getLastError() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return lastError;
+    }
+
+    /// Get the number of messages waiting for credits.
+    size_t getQueued() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size();
+    }
+
+    /// Get the remaining byte credits.
+    uint64_t getCreditBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return creditBytes;
+    }
+
+    /// Get the remaining message credits.
+    uint64_t getCreditMessages() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return creditMessages;
+    }
+
+    /// Get the number of messages sent.
+    uint64_t getSent() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent;
+    }
+
+    /// Get the number of dropped messages.
+    uint64_t getDropped() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dropped;
+    }
+
+    /// Get the number of messages replaced by a newer message.
+    uint64_t getCoalesced() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return coalesced;
+    }
+
+    /// Get the number of writes that waited for a buffer.
+    uint64_t getStalls() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stalls;
+    }
+
+private:
+    /// Send queued messages in order while credits allow. One thread sends at
+    /// a time so the order is kept; other threads only queue.
+    void pump(std::unique_lock<std::mutex>& lock)
+    {
+        if (sending)
+            return;
+        sending = true;
+        while (!queue.empty() && creditMessages > 0 && creditBytes >= queue.front()->size())
+        {
+            std::vector<char>* buffer = queue.front();
+            queue.pop_front();
+            creditBytes -= buffer->size();
+            creditMessages--;
+
+            lock.unlock();
+            handler(buffer->data(), buffer->size());
+            lock.lock();
+
+            sent++;
+            pool.release(buffer);
+            released.notify_one();
+        }
+        sending = false;
+    }
+
+    SendHandler handler;
+    buffer_pool pool;
+    Policy policy;
+    mutable std::mutex mutex;
+    std::condition_variable released;
+    std::deque<std::vector<char>*> queue;
+    uint64_t creditBytes = 0;
+    uint64_t creditMessages = 0;
+    bool sending = false;
+    bool closed = false;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t coalesced = 0;
+    uint64_t stalls = 0;
+    serialize::ParsingError lastError = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_FLOW_H
@@ -0,0 +1,295 @@
+/// @file serialize_fragment.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_FRAGMENT_H
+#define _SERIALIZE_FRAGMENT_H
+
+#include "serialize_core.h"
+#include <chrono>
+#include <functional>
+#include <vector>
+
+/// @brief The fragmenter class splits encoded messages into datagrams no
+/// larger than an MTU.
+/// @detail Each fragment starts with a header, big endian:
+///
+///     u32 sequence id, u16 fragment index, u16 fragment count,
+///     u32 message size, u32 fragment offset within the message
+///
+/// A reassembler rebuilds the message from fragments arriving in any order. e.g.
+///
+/// fragmenter frag([&](const char* data, size_t size) { sendto(sock, data, size, ...); }, 1200);
+/// frag.send(ms, allData);
+class fragmenter
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> SendHandler;
+
+    static const size_t HEADER_SIZE = 16;
+
+    /// @param[in] handler - sends one datagram
+    /// @param[in] mtu - the maximum datagram size, larger than HEADER_SIZE
+    fragmenter(SendHandler handler_, size_t mtu_ = 1200) :
+        handler(handler_), mtu(mtu_ > HEADER_SIZE ? mtu_ : HEADER_SIZE + 1),
+        sequence(static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()))
+    {
+        datagram.reserve(mtu);
+    }
+
+    /// Encode a message and send its fragments.
+    /// @return The encode result. CONTAINER_TOO_MANY if the message needs
+    /// more than 65535 fragments. Nothing is sent on error.
+    template <class T>
+    serialize::result send(serialize& ms, T& message)
+    {
+        serialize::result r = ms.encode(message, scratch);
+        if (r.ok() && !send(scratch.data(), scratch.size()))
+            r.error = serialize::ParsingError::CONTAINER_TOO_MANY;
+        return r;
+    }
+
+    /// Send the fragments of an encoded message.
+    /// @return False if the message needs more than 65535 fragments.
+    bool send(const char* data, size_t size)
+    {
+        size_t payload = mtu - HEADER_SIZE;
+        size_t count = size == 0 ? 1 : (size + payload - 1) / payload;
+        if (count > 0xFFFF || static_cast<uint64_t>(size) > 0xFFFFFFFFull)
+            return false;
+
+        sequence++;
+        for (size_t index = 0; index < count; index++)
+        {
+            size_t offset = index * payload;
+            size_t n = size - offset < payload ? size - offset : payload;
+            datagram.clear();
+            put(sequence, 4);
+            put(index, 2);
+            put(count, 2);
+            put(size, 4);
+            put(offset, 4);
+            datagram.insert(datagram.end(), data + offset, data + offset + n);
+            handler(datagram.data(), datagram.size());
+        }
+        return true;
+    }
+
+private:
+    void put(size_t value, size_t bytes)
+    {
+        for (size_t i = bytes; i > 0; i--)
+            datagram.push_back(static_cast<char>(value >> (8 * (i - 1))));
+    }
+
+    SendHandler handler;
+    size_t mtu;
+    uint32_t sequence;      // Clock based so a restarted sender does not repeat recent ids
+    std::vector<char> datagram;
+    std::vector<char> scratch;
+};
+
+/// @brief The reassembler class rebuilds messages from fragmenter datagrams.
+/// @detail Each fragment payload is copied once, directly to its offset in a
+/// contiguous message buffer, so a complete message is passed to the handler
+/// without another copy. Memory is bounded: at most limits::messages
+/// reassemblies of at most limits::bytes each are in progress, and their
+/// buffers are reused. When all are in use the oldest is evicted. A
+/// reassembly not completed within limits::timeout is dropped by poll().
+/// Duplicate fragments, including those of recently completed messages, are
+/// ignored. A fragment whose offset or size disagrees with its index or with
+/// earlier fragments is invalid, so a message never completes with holes.
+/// Use one reassembler per sender. e.g.
+///
+/// reassembler reasm([&](const char* data, size_t size) { ms.decode(data, size, allData); });
+/// n = recv(sock, datagram, sizeof(datagram), 0);
+/// reasm.receive(datagram, n);
+/// ...
+/// reasm.poll();
+class reassembler
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> MessageHandler;
+    typedef std::chrono::steady_clock clock;
+
+    /// Reassembly memory and time bounds
+    struct limits
+    {
+        size_t messages = 8;
+        size_t bytes = 1024 * 1024;
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(500);
+    };
+
+    explicit reassembler(MessageHandler handler_) : reassembler(handler_, limits()) {}
+
+    reassembler(MessageHandler handler_, const limits& limits_) :
+        handler(handler_), limit(limits_), slots(limits_.messages > 0 ? limits_.messages : 1), recent(RECENT, 0) {}
+
+    /// Add a received datagram. A completed message is passed to the handler.
+    /// @return False if the datagram is not a valid fragment.
+    bool receive(const char* data, size_t size)
+    {
+        if (size < fragmenter::HEADER_SIZE)
+            return invalid();
+
+        uint32_t sequence = static_cast<uint32_t>(load(data, 4));
+        size_t index = load(data + 4, 2);
+        size_t count = load(data + 6, 2);
+        size_t total = load(data + 8, 4);
+        size_t offset = load(data + 12, 4);
+        size_t n = size - fragmenter::HEADER_SIZE;
+        if (index >= count || total > limit.bytes || offset > total || n > total - offset)
+            return invalid();
+
+        // Fragments other than the last have the same payload size, and each
+        // is at its index times that size, so they cannot overlap or leave holes
+        bool last = index + 1 == count;
+        size_t payload = last && index > 0 ? offset / index : n;
+        if (offset != index * payload || (last ? offset + n != total || n > payload : n == 0))
+            return invalid();
+
+        if (completed(sequence))
+        {
+            duplicates++;
+            return true;
+        }
+
+        slot* s = find(sequence, count, total);
+        if (s == nullptr || (s->payload != 0 && s->payload != payload))
+            return invalid();
+        if (count > 1)
+            s->payload = payload;
+        if (s->have[index])
+        {
+            duplicates++;
+            return true;
+        }
+
+        s->have[index] = true;
+        s->received++;
+        s->receivedBytes += n;
+        if (n > 0)
+            memcpy(&s->bytes[offset], data + fragmenter::HEADER_SIZE, n);
+
+        if (s->received == s->count && s->receivedBytes != s->bytes.size())
+        {
+            s->active = false;
+            return invalid();
+        }
+        if (s->received == s->count)
+        {
+            s->active = false;
+            recent[recentNext++ % RECENT] = sequence;
+            recentCount++;
+            complete++;
+            handler(s->bytes.data(), s->bytes.size());
+        }
+        return true;
+    }
+
+    /// Drop reassemblies older than the timeout.
+    /// @return The number dropped.
+    size_t poll()
+    {
+        clock::time_point now = clock::now();
+        size_t dropped = 0;
+        for (slot& s : slots)
+        {
+            if (s.active && now - s.started >= limit.timeout)
+            {
+                s.active = false;
+                dropped++;
+            }
+        }
+        expired += dropped;
+        return dropped;
+    }
+
+    uint64_t getCompleted() const { return complete; }
+    uint64_t getExpired() const { return expired; }
+    uint64_t getEvicted() const { return evicted; }
+    uint64_t getDuplicates() const { return duplicates; }
+    uint64_t getInvalid() const { return invalids; }
+
+private:
+    static const size_t RECENT = 64;
+
+    struct slot
+    {
+        bool active = false;
+        uint32_t sequence = 0;
+        size_t count = 0;
+        size_t received = 0;
+        size_t receivedBytes = 0;
+        size_t payload = 0;         // Payload size of all but the last fragment, 0 until known
+        std::vector<bool> have;
+        std::vector<char> bytes;
+        clock::time_point started;
+    };
+
+    static size_t load(const char* p, size_t bytes)
+    {
+        size_t value = 0;
+        for (size_t i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+
+    bool invalid()
+    {
+        invalids++;
+        return false;
+    }
+
+    bool completed(uint32_t sequence) const
+    {
+        size_t n = recentCount < RECENT ? recentCount : RECENT;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (recent[i] == sequence)
+                return true;
+        }
+        return false;
+    }
+
+    /// Find the reassembly of a message, or start one in a free or the oldest slot.
+    /// @return The slot, or nullptr if the fragment disagrees with earlier fragments.
+    slot* find(uint32_t sequence, size_t count, size_t total)
+    {
+        slot* oldest = nullptr;
+        for (slot& s : slots)
+        {
+            if (s.active && s.sequence == sequence)
+                return s.count == count && s.bytes.size() == total ? &s : nullptr;
+            if (oldest == nullptr || (oldest->active && (!s.active || s.started < oldest->started)))
+                oldest = &s;
+        }
+
+        if (oldest->active)
+            evicted++;
+        oldest->active = true;
+        oldest->sequence = sequence;
+        oldest->count = count;
+        oldest->received = 0;
+        oldest->receivedBytes = 0;
+        oldest->payload = 0;
+        oldest->have.assign(count, false);
+        oldest->bytes.resize(total);
+        oldest->started = clock::now();
+        return oldest;
+    }
+
+    MessageHandler handler;
+    limits limit;
+    std::vector<slot> slots;
+    std::vector<uint32_t> recent;
+    size_t recentNext = 0;
+    size_t recentCount = 0;
+    uint64_t complete = 0;
+    uint64_t expired = 0;
+    uint64_t evicted = 0;
+    uint64_t duplicates = 0;
+    uint64_t invalids = 0;
+};
+
+#endif // _SERIALIZE_FRAGMENT_H
@@ -0,0 +1,217 @@
+/// @file serialize_frame.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_FRAME_H
+#define _SERIALIZE_FRAME_H
+
+#include "serialize_core.h"
+#include <functional>
+#include <vector>
+
+/// Compute the CRC-32 (IEEE 802.3) of bytes.
+/// @param[in] data - the bytes
+/// @param[in] size - the number of bytes
+/// @param[in] crc - the CRC of preceding bytes, to compute a CRC in pieces
+inline uint32_t frame_crc32(const char* data, size_t size, uint32_t crc = 0)
+{
+    struct table
+    {
+        uint32_t entries[256];
+        table()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[i] = c;
+            }
+        }
+    };
+    static const table t;
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = t.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/// @brief Self-synchronizing frames for serial and stream links.
+/// @detail A frame is, big endian:
+///
+///     u8 0xA5, u8 0x5A, u16 length, u16 length check, payload, u32 CRC-32 of payload
+///
+/// The length check is the low 16 bits of the CRC-32 of the two length bytes,
+/// so a header shifted by lost bytes rarely passes and the reader does not wait
+/// for a bogus length. After lost or corrupted bytes the frame_reader finds the
+/// next sync marker whose length check and CRC pass, so the stream recovers
+/// within one frame.
+struct frame_format
+{
+    static const uint8_t MARKER0 = 0xA5;
+    static const uint8_t MARKER1 = 0x5A;
+    static const size_t HEADER_SIZE = 6;
+    static const size_t TRAILER_SIZE = 4;
+    static const size_t MAX_PAYLOAD = 0xFFFF;
+
+    /// Get the header check of the two big endian length bytes.
+    static uint16_t lengthCheck(const char* length) { return static_cast<uint16_t>(frame_crc32(length, 2)); }
+};
+
+/// Append a frame holding the payload bytes.
+/// @return False if the payload exceeds frame_format::MAX_PAYLOAD.
+inline bool write_frame(const char* data, size_t size, std::vector<char>& out)
+{
+    if (size > frame_format::MAX_PAYLOAD)
+        return false;
+
+    uint32_t crc = frame_crc32(data, size);
+    char header[frame_format::HEADER_SIZE] = {
+        static_cast<char>(frame_format::MARKER0), static_cast<char>(frame_format::MARKER1),
+        static_cast<char>(size >> 8), static_cast<char>(size), 0, 0 };
+    uint16_t check = frame_format::lengthCheck(header + 2);
+    header[4] = static_cast<char>(check >> 8);
+    header[5] = static_cast<char>(check);
+    char trailer[frame_format::TRAILER_SIZE] = {
+        static_cast<char>(crc >> 24), static_cast<char>(crc >> 16), static_cast<char>(crc >> 8), static_cast<char>(crc) };
+
+    out.insert(out.end(), header, header + sizeof(header));
+    out.insert(out.end(), data, data + size);
+    out.insert(out.end(), trailer, trailer + sizeof(trailer));
+    return true;
+}
+
+/// Encode a message and append it as a frame. e.g.
+///
+/// encode_frame(ms, alarmLog, buf);
+/// uart.write(buf.data(), buf.size());
+///
+/// @return The encode result. STRING_TOO_LONG if the message exceeds a frame.
+template <class T>
+serialize::result encode_frame(serialize& ms, T& message, std::vector<char>& out)
+{
+    std::vector<char> payload;
+    serialize::result r = ms.encode(message, payload);
+    if (r.ok() && !write_frame(payload.data(), payload.size(), out))
+        r.error = serialize::ParsingError::STRING_TOO_LONG;
+    return r;
+}
+
+/// @brief The frame_reader class extracts frames from stream bytes and
+/// resynchronizes after corruption.
+/// @detail Bytes may arrive split at any point. The next sync marker is found
+/// with memchr(), which the C library scans a machine word or vector at a time.
+/// A candidate frame is accepted only if its length check and CRC pass;
+/// otherwise the reader skips one byte and scans again. The payload passed to
+/// the handler is valid until the handler returns, and the handler must not
+/// call receive(). e.g.
+///
+/// frame_reader reader([&](const char* data, size_t size) { ms.decode(data, size, alarmLog); });
+/// n = uart.read(buf, sizeof(buf));
+/// reader.receive(buf, n);
+class frame_reader
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> FrameHandler;
+
+    explicit frame_reader(FrameHandler handler_) : handler(handler_) {}
+
+    /// Add received bytes. Each valid frame's payload is passed to the handler.
+    void receive(const char* data, size_t size)
+    {
+        buffer.insert(buffer.end(), data, data + size);
+        parse();
+
+        // Keep only the unparsed bytes
+        if (start > 0)
+        {
+            buffer.erase(buffer.begin(), buffer.begin() + start);
+            start = 0;
+        }
+    }
+
+    /// Get the number of valid frames.
+    uint64_t getFrames() const { return frames; }
+
+    /// Get the number of bytes skipped while searching for a frame.
+    uint64_t getSkipped() const { return skipped; }
+
+    /// Get the number of candidate frames rejected by the CRC.
+    uint64_t getCrcErrors() const { return crcErrors; }
+
+private:
+    void parse()
+    {
+        while (start < buffer.size())
+        {
+            const char* p = buffer.data() + start;
+            size_t available = buffer.size() - start;
+
+            const char* marker = static_cast<const char*>(memchr(p, frame_format::MARKER0, available));
+            if (marker == nullptr)
+            {
+                skip(available);
+                return;
+            }
+            if (marker != p)
+            {
+                skip(static_cast<size_t>(marker - p));
+                continue;
+            }
+
+            if (available >= 2 && static_cast<uint8_t>(p[1]) != frame_format::MARKER1)
+            {
+                skip(1);
+                continue;
+            }
+            if (available < frame_format::HEADER_SIZE)
+                return;
+
+            size_t length = load(p + 2, 2);
+            if (frame_format::lengthCheck(p + 2) != load(p + 4, 2))
+            {
+                skip(1);
+                continue;
+            }
+            size_t total = frame_format::HEADER_SIZE + length + frame_format::TRAILER_SIZE;
+            if (available < total)
+                return;
+
+            const char* payload = p + frame_format::HEADER_SIZE;
+            if (frame_crc32(payload, length) != load(payload + length, 4))
+            {
+                crcErrors++;
+                skip(1);
+                continue;
+            }
+
+            frames++;
+            start += total;
+            handler(payload, length);
+        }
+    }
+
+    void skip(size_t n)
+    {
+        start += n;
+        skipped += n;
+    }
+
+    static uint32_t load(const char* p, size_t bytes)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+
+    FrameHandler handler;
+    std::vector<char> buffer;
+    size_t start = 0;
+    uint64_t frames = 0;
+    uint64_t skipped = 0;
+    uint64_t crcErrors = 0;
+};
+
+#endif // _SERIALIZE_FRAME_H
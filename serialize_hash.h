@@ -0,0 +1,152 @@
+/// @file serialize_hash.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_HASH_H
+#define _SERIALIZE_HASH_H
+
+#include "serialize_core.h"
+#include <vector>
+
+/// A 128-bit hash of encoded bytes.
+struct content_hash
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const content_hash& other) const { return low == other.low && high == other.high; }
+    bool operator!=(const content_hash& other) const { return !(*this == other); }
+};
+
+/// @brief The content_hasher class computes a 128-bit hash of bytes that may
+/// arrive in pieces. The hash is the same on every platform. It is fast and
+/// well mixed for dedupe and cache keys, but is not a cryptographic hash. e.g.
+///
+/// content_hasher hasher;
+/// hasher.update(header, headerSize);
+/// hasher.update(body, bodySize);
+/// content_hash hash = hasher.digest();
+class content_hasher
+{
+public:
+    explicit content_hasher(uint64_t seed = 0) :
+        lane0(seed + P1 + P2), lane1(seed ^ P3) {}
+
+    /// Hash more bytes.
+    /// @param[in] data - the bytes
+    /// @param[in] size - the number of bytes
+    void update(const char* data, size_t size)
+    {
+        total += size;
+        if (pending > 0)
+        {
+            size_t n = size < BLOCK - pending ? size : BLOCK - pending;
+            memcpy(block + pending, data, n);
+            pending += n;
+            data += n;
+            size -= n;
+            if (pending < BLOCK)
+                return;
+            mix_block(block);
+            pending = 0;
+        }
+        for (; size >= BLOCK; data += BLOCK, size -= BLOCK)
+            mix_block(data);
+        memcpy(block, data, size);
+        pending = size;
+    }
+
+    /// Get the hash of all bytes so far. More bytes may be added afterwards.
+    content_hash digest() const
+    {
+        uint64_t a = lane0, b = lane1;
+        if (pending > 0)
+        {
+            // Zero padding is distinguished by the total length
+            char last[BLOCK] = { 0 };
+            memcpy(last, block, pending);
+            a = round(a, load_u64(last));
+            b = round(b, load_u64(last + 8));
+        }
+
+        content_hash hash;
+        hash.low = fmix(a + rotl(b, 23) + total);
+        hash.high = fmix(b ^ rotl(a, 41) ^ (total * P1));
+        return hash;
+    }
+
+    /// Hash a buffer.
+    static content_hash of(const char* data, size_t size, uint64_t seed = 0)
+    {
+        content_hasher hasher(seed);
+        hasher.update(data, size);
+        return hasher.digest();
+    }
+
+private:
+    static const size_t BLOCK = 16;
+    static const uint64_t P1 = 0x9E3779B185EBCA87ull;
+    static const uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    static const uint64_t P3 = 0x165667B19E3779F9ull;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t round(uint64_t acc, uint64_t word)
+    {
+        acc += word * P2;
+        acc = rotl(acc, 31);
+        return acc * P1;
+    }
+
+    static uint64_t fmix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    /// Load 8 bytes as little endian on every platform.
+    static uint64_t load_u64(const char* p)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+
+    void mix_block(const char* p)
+    {
+        lane0 = round(lane0, load_u64(p));
+        lane1 = round(lane1, load_u64(p + 8));
+    }
+
+    uint64_t lane0;
+    uint64_t lane1;
+    uint64_t total = 0;
+    char block[BLOCK] = { 0 };
+    size_t pending = 0;
+};
+
+/// Encode an object canonically and hash the encoded bytes. Equal objects
+/// have equal bytes and equal hashes. The bytes are hashed right after they
+/// are written, while still in cache, since user defined object sizes are
+/// patched after their fields are written. e.g.
+///
+/// content_hash hash;
+/// serialize::result r = encode_hashed(ms, dataSet, buf, hash);
+/// if (r.ok() && cache.count(hash)) ...
+template <class T>
+serialize::result encode_hashed(serialize& ms, T& object, std::vector<char>& out, content_hash& hash)
+{
+    bool canonical = ms.getCanonical();
+    ms.setCanonical(true);
+    serialize::result r = ms.encode(object, out);
+    ms.setCanonical(canonical);
+    hash = content_hasher::of(out.data(), out.size());
+    return r;
+}
+
+#endif // _SERIALIZE_HASH_H
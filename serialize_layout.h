@@ -0,0 +1,652 @@
+/// @file serialize_layout.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_LAYOUT_H
+#define _SERIALIZE_LAYOUT_H
+
+#include "serialize_core.h"
+#include <string>
+#include <vector>
+
+/// Kinds of fields described by a type_layout. The scalar kinds are encoded
+/// as a LITERAL. Containers are described by a container kind and an element
+/// kind (and a key kind for maps).
+enum class field_kind : uint8_t
+{
+    BOOL,
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    STRING,         // std::string
+    WSTRING,        // std::wstring
+    CSTRING,        // char[] including the terminating null
+    OBJECT,         // User defined object by value
+    OBJECT_PTR,     // User defined object by pointer (container elements only)
+    VECTOR,
+    LIST,
+    SET,
+    MAP
+};
+
+struct type_layout;
+
+/// Describes one field written by a serialize::I write() function.
+struct field_desc
+{
+    const char* name;
+    field_kind kind;
+    field_kind key;             // MAP key kind
+    field_kind element;         // Container element or MAP value kind
+    const type_layout* object;  // Layout of OBJECT fields or OBJECT/OBJECT_PTR elements
+};
+
+/// Describes the fields of a serialize::I type in write() order.
+struct type_layout
+{
+    const char* name;
+    const field_desc* fields;
+    size_t count;
+};
+
+/// Returns true if the kind is a scalar encoded as a LITERAL.
+constexpr bool is_scalar(field_kind kind)
+{
+    return kind <= field_kind::DOUBLE;
+}
+
+/// Returns true if the kind is a signed integer.
+constexpr bool is_signed(field_kind kind)
+{
+    return kind == field_kind::INT8 || kind == field_kind::INT16 ||
+        kind == field_kind::INT32 || kind == field_kind::INT64;
+}
+
+/// Returns the encoded size of a scalar kind in bytes or 0 if not a scalar.
+constexpr size_t scalar_size(field_kind kind)
+{
+    return kind == field_kind::BOOL || kind == field_kind::INT8 || kind == field_kind::UINT8 ? 1 :
+        kind == field_kind::INT16 || kind == field_kind::UINT16 ? 2 :
+        kind == field_kind::INT32 || kind == field_kind::UINT32 || kind == field_kind::FLOAT ? 4 :
+        kind == field_kind::INT64 || kind == field_kind::UINT64 || kind == field_kind::DOUBLE ? 8 : 0;
+}
+
+/// Describe a scalar or string field.
+constexpr field_desc layout_field(const char* name, field_kind kind)
+{
+    return field_desc{ name, kind, kind, kind, nullptr };
+}
+
+/// Describe a user defined object field stored by value.
+constexpr field_desc layout_object(const char* name, const type_layout& object)
+{
+    return field_desc{ name, field_kind::OBJECT, field_kind::OBJECT, field_kind::OBJECT, &object };
+}
+
+/// Describe a vector, list or set field with scalar elements.
+constexpr field_desc layout_container(const char* name, field_kind container, field_kind element)
+{
+    return field_desc{ name, container, element, element, nullptr };
+}
+
+/// Describe a vector, list or set field with user defined elements stored
+/// by value (OBJECT) or by pointer (OBJECT_PTR).
+constexpr field_desc layout_container(const char* name, field_kind container, field_kind element, const type_layout& object)
+{
+    return field_desc{ name, container, element, element, &object };
+}
+
+/// Describe a map field with scalar keys and scalar values.
+constexpr field_desc layout_map(const char* name, field_kind key, field_kind value)
+{
+    return field_desc{ name, field_kind::MAP, key, value, nullptr };
+}
+
+/// Describe a map field with scalar keys and user defined values stored
+/// by value (OBJECT) or by pointer (OBJECT_PTR).
+constexpr field_desc layout_map(const char* name, field_kind key, field_kind value, const type_layout& object)
+{
+    return field_desc{ name, field_kind::MAP, key, value, &object };
+}
+
+/// Construct a type_layout from a field array.
+template <size_t N>
+constexpr type_layout make_layout(const char* name, const field_desc (&fields)[N])
+{
+    return type_layout{ name, fields, N };
+}
+
+/// Get the field_kind of a built-in C++ type. Enumerations use the underlying type.
+template <typename T, bool IsEnum = std::is_enum<T>::value>
+struct field_kind_of
+{
+    static_assert(std::is_arithmetic<T>::value, "T must be a built-in data type");
+    static const field_kind value =
+        std::is_same<T, bool>::value ? field_kind::BOOL :
+        std::is_floating_point<T>::value ? (sizeof(T) == 4 ? field_kind::FLOAT : field_kind::DOUBLE) :
+        sizeof(T) == 1 ? (std::is_signed<T>::value ? field_kind::INT8 : field_kind::UINT8) :
+        sizeof(T) == 2 ? (std::is_signed<T>::value ? field_kind::INT16 : field_kind::UINT16) :
+        sizeof(T) == 4 ? (std::is_signed<T>::value ? field_kind::INT32 : field_kind::UINT32) :
+        (std::is_signed<T>::value ? field_kind::INT64 : field_kind::UINT64);
+};
+
+template <typename T>
+struct field_kind_of<T, true> : field_kind_of<typename std::underlying_type<T>::type> {};
+
+/// Load a big endian encoded scalar, e.g. from a fixed offset within an encoded 
+/// message. No bounds checking is performed.
+/// @param[in] p - the first encoded byte
+/// @return The value
+template <typename T>
+T wire_load(const char* p)
+{
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "T must be a built-in data type");
+    const int one = 1;
+    bool le = *reinterpret_cast<const char*>(&one) == 1;
+
+    char native[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++)
+        native[i] = p[le ? sizeof(T) - 1 - i : i];
+    T value;
+    memcpy(&value, native, sizeof(T));
+    return value;
+}
+
+/// @brief Bounds checked reader over an encoded message in memory.
+/// @detail Multi-byte values are read in the serialize wire byte order (big endian).
+/// The first error is latched and all following reads fail.
+class wire_reader
+{
+public:
+    wire_reader(const char* data, size_t size) :
+        begin(data), pos(data), limit(data + size) {}
+
+    bool good() const { return error == serialize::ParsingError::NONE; }
+    serialize::ParsingError getLastError() const { return error; }
+
+    /// Offset of the next byte to read from the start of the message.
+    size_t offset() const { return static_cast<size_t>(pos - begin); }
+
+    /// Bytes remaining before the current parse limit.
+    size_t remaining() const { return static_cast<size_t>(limit - pos); }
+
+    const char* data() const { return begin; }
+    const char* current() const { return pos; }
+
+    /// Set the parse limit (e.g. the end of the current user defined object).
+    /// @return The previous parse limit.
+    const char* setLimit(const char* newLimit)
+    {
+        const char* old = limit;
+        limit = newLimit;
+        return old;
+    }
+
+    /// Latch an error. Only the first error is kept.
+    void fail(serialize::ParsingError e)
+    {
+        if (good())
+            error = e;
+        pos = limit;
+    }
+
+    /// Read and verify a type tag.
+    bool readType(serialize::Type type)
+    {
+        if (!require(1))
+            return false;
+        if (static_cast<serialize::Type>(static_cast<uint8_t>(*pos)) != type)
+        {
+            fail(serialize::ParsingError::TYPE_MISMATCH);
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    uint8_t readU8()
+    {
+        if (!require(1))
+            return 0;
+        return static_cast<uint8_t>(*pos++);
+    }
+
+    uint16_t readU16()
+    {
+        if (!require(2))
+            return 0;
+        uint16_t v = static_cast<uint16_t>((static_cast<uint8_t>(pos[0]) << 8) | static_cast<uint8_t>(pos[1]));
+        pos += 2;
+        return v;
+    }
+
+    /// Read a big endian value of 1 to 8 bytes.
+    uint64_t readBits(size_t size)
+    {
+        if (!require(size))
+            return 0;
+        uint64_t v = 0;
+        for (size_t i = 0; i < size; i++)
+            v = (v << 8) | static_cast<uint8_t>(pos[i]);
+        pos += size;
+        return v;
+    }
+
+    /// Return a pointer to the next size bytes and advance past them.
+    const char* readBytes(size_t size)
+    {
+        if (!require(size))
+            return nullptr;
+        const char* p = pos;
+        pos += size;
+        return p;
+    }
+
+    /// Advance the read position to p if within the parse limit.
+    void seek(const char* p)
+    {
+        if (p < pos || p > limit)
+            fail(serialize::ParsingError::STREAM_ERROR);
+        else
+            pos = p;
+    }
+
+private:
+    bool require(size_t size)
+    {
+        if (!good())
+            return false;
+        if (remaining() < size)
+        {
+            fail(serialize::ParsingError::END_OF_FILE);
+            return false;
+        }
+        return true;
+    }
+
+    const char* begin;
+    const char* pos;
+    const char* limit;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+/// @brief Walks an encoded user defined object using its type_layout without
+/// decoding into objects.
+/// @detail Framing follows serialize::read(): fields missing from an older
+/// sender are reported with missingField() and extra fields from a newer sender
+/// are skipped. The Visitor receives:
+///
+///     void beginObject(const type_layout& layout);
+///     void endObject(const type_layout& layout);
+///     void beginField(const field_desc& field);
+///     void endField(const field_desc& field);
+///     void missingField(const field_desc& field);
+///     void scalar(field_kind kind, uint64_t bits);
+///     void string(field_kind kind, const char* data, size_t size);
+///     void beginContainer(const field_desc& field, size_t count);
+///     void endContainer(const field_desc& field);
+///     void beginElement(size_t index);
+///     void mapValue();
+///     void nullObject();
+///
+/// string() receives the encoded bytes; WSTRING characters are WCHAR_SIZE big
+/// endian bytes each.
+///
+/// Nested objects and containers are walked with an explicit, fixed size stack
+/// instead of recursion, so deep or hostile input uses bounded stack space and
+/// no allocation. Objects nested deeper than the maximum depth fail with 
+/// ParsingError::DEPTH_EXCEEDED.
+template <class Visitor>
+class layout_walker
+{
+public:
+    layout_walker(wire_reader& reader_, Visitor& visitor_) : reader(reader_), visitor(visitor_) {}
+
+    /// Set the maximum nesting depth of user defined objects. 
+    /// @param[in] maxDepth_ - the depth, at most serialize::MAX_OBJECT_DEPTH
+    void setMaxDepth(uint16_t maxDepth_)
+    {
+        maxDepth = maxDepth_ < serialize::MAX_OBJECT_DEPTH ? maxDepth_ : serialize::MAX_OBJECT_DEPTH;
+    }
+
+    /// Walk one user defined object: USER_DEFINED type, size and fields.
+    /// @param[in] layout - the object layout
+    /// @return True if the object was walked without error.
+    bool object(const type_layout& layout)
+    {
+        top = 0;
+        depth = 0;
+        begin_object(layout);
+        while (top > 0 && reader.good())
+        {
+            if (stack[top - 1].layout)
+                step_object(stack[top - 1]);
+            else
+                step_container(stack[top - 1]);
+        }
+        return reader.good();
+    }
+
+private:
+    /// An object being walked field by field, or a container element by element
+    struct frame
+    {
+        const type_layout* layout;      // Object layout, or nullptr for a container
+        const field_desc* field;        // Object field in progress, or the container field
+        const char* end;                // Object end
+        const char* outerLimit;         // Reader limit to restore at the object end
+        uint16_t index;                 // Next field or element index
+        uint16_t count;                 // Container element count
+        bool tagged;                    // Container elements have a type
+        bool mapKeyDone;                // Map element key walked, value next
+    };
+
+    // An object level holds at most one object and one container frame
+    static const size_t MAX_FRAMES = 2 * serialize::MAX_OBJECT_DEPTH;
+
+    frame& push()
+    {
+        frame& f = stack[top++];
+        f = frame();
+        return f;
+    }
+
+    /// Read an object header and push its frame. 
+    void begin_object(const type_layout& layout)
+    {
+        if (depth >= maxDepth)
+        {
+            reader.fail(serialize::ParsingError::DEPTH_EXCEEDED);
+            return;
+        }
+        if (!reader.readType(serialize::Type::USER_DEFINED))
+            return;
+
+        // Size is measured from the start of the size field
+        const char* sizePos = reader.current();
+        uint16_t size = reader.readU16();
+        if (!reader.good())
+            return;
+        if (size < sizeof(size) || size - sizeof(size) > reader.remaining())
+        {
+            reader.fail(serialize::ParsingError::END_OF_FILE);
+            return;
+        }
+
+        frame& f = push();
+        f.layout = &layout;
+        f.end = sizePos + size;
+        f.outerLimit = reader.setLimit(f.end);
+        depth++;
+        visitor.beginObject(layout);
+    }
+
+    void step_object(frame& f)
+    {
+        // The previous field completed, including any nested frames
+        if (f.field)
+        {
+            visitor.endField(*f.field);
+            f.field = nullptr;
+        }
+
+        if (f.index == f.layout->count)
+        {
+            // Skip over extra data sent by a newer sender
+            reader.seek(f.end);
+            reader.setLimit(f.outerLimit);
+            const type_layout& layout = *f.layout;
+            top--;
+            depth--;
+            visitor.endObject(layout);
+            return;
+        }
+
+        const field_desc& field = f.layout->fields[f.index++];
+        if (reader.current() >= f.end)
+        {
+            visitor.missingField(field);
+            return;
+        }
+        f.field = &field;
+        visitor.beginField(field);
+        begin_field(field);
+    }
+
+    void step_container(frame& f)
+    {
+        const field_desc& field = *f.field;
+        if (f.index == f.count)
+        {
+            top--;
+            visitor.endContainer(field);
+            return;
+        }
+
+        if (field.kind == field_kind::MAP && !f.mapKeyDone)
+        {
+            visitor.beginElement(f.index);
+            element(field.key, nullptr, false);
+            visitor.mapValue();
+            f.mapKeyDone = true;
+            return;
+        }
+
+        if (field.kind != field_kind::MAP)
+            visitor.beginElement(f.index);
+        f.mapKeyDone = false;
+        f.index++;
+        element(field.element, field.object, f.tagged);
+    }
+
+    /// Walk a field. Objects and containers push a frame and complete later.
+    void begin_field(const field_desc& f)
+    {
+        if (is_scalar(f.kind))
+        {
+            if (reader.readType(serialize::Type::LITERAL))
+                scalar(f.kind);
+            return;
+        }
+
+        switch (f.kind)
+        {
+        case field_kind::STRING:
+        case field_kind::CSTRING:
+            text(serialize::Type::STRING, f.kind, 1);
+            break;
+        case field_kind::WSTRING:
+            text(serialize::Type::WSTRING, f.kind, serialize::WCHAR_SIZE);
+            break;
+        case field_kind::OBJECT:
+            begin_object(*f.object);
+            break;
+        case field_kind::VECTOR:
+            begin_container(f, serialize::Type::VECTOR);
+            break;
+        case field_kind::LIST:
+            begin_container(f, serialize::Type::LIST);
+            break;
+        case field_kind::SET:
+            begin_container(f, serialize::Type::SET);
+            break;
+        case field_kind::MAP:
+            begin_container(f, serialize::Type::MAP);
+            break;
+        default:
+            reader.fail(serialize::ParsingError::INVALID_INPUT);
+            break;
+        }
+    }
+
+    void scalar(field_kind kind)
+    {
+        uint64_t bits = reader.readBits(scalar_size(kind));
+        if (reader.good())
+            visitor.scalar(kind, bits);
+    }
+
+    void text(serialize::Type type, field_kind kind, size_t charSize)
+    {
+        if (!reader.readType(type))
+            return;
+        uint16_t size = reader.readU16();
+        if (!reader.good())
+            return;
+        if (size > serialize::MAX_STRING_SIZE)
+        {
+            reader.fail(serialize::ParsingError::STRING_TOO_LONG);
+            return;
+        }
+        const char* p = reader.readBytes(size * charSize);
+        if (p)
+            visitor.string(kind, p, size * charSize);
+    }
+
+    void begin_container(const field_desc& f, serialize::Type type)
+    {
+        if (!reader.readType(type))
+            return;
+        uint16_t count = reader.readU16();
+        if (!reader.good())
+            return;
+        if (count > serialize::MAX_CONTAINER_SIZE)
+        {
+            reader.fail(serialize::ParsingError::CONTAINER_TOO_MANY);
+            return;
+        }
+
+        frame& c = push();
+        c.field = &f;
+        c.count = count;
+        // std::vector<bool> elements are written with a type
+        c.tagged = f.kind == field_kind::VECTOR && f.element == field_kind::BOOL;
+        visitor.beginContainer(f, count);
+    }
+
+    void element(field_kind kind, const type_layout* layout, bool tagged)
+    {
+        if (is_scalar(kind))
+        {
+            if (!tagged || reader.readType(serialize::Type::LITERAL))
+                scalar(kind);
+        }
+        else if (kind == field_kind::OBJECT && layout)
+        {
+            begin_object(*layout);
+        }
+        else if (kind == field_kind::OBJECT_PTR && layout)
+        {
+            bool notNULL = reader.readU8() != 0;
+            if (!reader.good())
+                return;
+            if (notNULL)
+                begin_object(*layout);
+            else
+                visitor.nullObject();
+        }
+        else
+        {
+            reader.fail(serialize::ParsingError::INVALID_INPUT);
+        }
+    }
+
+    wire_reader& reader;
+    Visitor& visitor;
+    frame stack[MAX_FRAMES];
+    size_t top = 0;
+    uint16_t depth = 0;
+    uint16_t maxDepth = serialize::MAX_OBJECT_DEPTH;
+};
+
+/// @brief Reads consecutive encoded user defined objects (records) from a stream,
+/// such as an archive file written with repeated serialize::write() calls.
+/// @detail Records are returned in place from an internal chunk buffer and are
+/// valid until the next call to next().
+class record_reader
+{
+public:
+    /// @param[in] is - the input stream of encoded records
+    /// @param[in] chunkSize - the read size; at least one maximum size record
+    explicit record_reader(std::istream& is_, size_t chunkSize = 1 << 20) :
+        is(is_), buffer(chunkSize < MAX_RECORD_SIZE ? MAX_RECORD_SIZE : chunkSize) {}
+
+    /// Get the next encoded record.
+    /// @param[out] data - the record bytes
+    /// @param[out] size - the record size
+    /// @return True if a record is available. False at end of stream or on error.
+    bool next(const char*& data, size_t& size)
+    {
+        if (error != serialize::ParsingError::NONE)
+            return false;
+        if (!fill(HEADER_SIZE))
+            return false;
+
+        const char* p = &buffer[head];
+        if (static_cast<serialize::Type>(static_cast<uint8_t>(p[0])) != serialize::Type::USER_DEFINED)
+        {
+            error = serialize::ParsingError::TYPE_MISMATCH;
+            return false;
+        }
+
+        size_t recordSize = 1 + ((static_cast<uint8_t>(p[1]) << 8) | static_cast<uint8_t>(p[2]));
+        if (!fill(recordSize))
+            return false;
+
+        data = &buffer[head];
+        size = recordSize;
+        head += recordSize;
+        offset += recordSize;
+        return true;
+    }
+
+    /// Get the stream offset of the next record.
+    uint64_t getOffset() const { return offset; }
+
+    serialize::ParsingError getLastError() const { return error; }
+
+private:
+    static const size_t HEADER_SIZE = 3;
+    static const size_t MAX_RECORD_SIZE = 1 + 0xFFFF;
+
+    /// Ensure size bytes are buffered at head.
+    bool fill(size_t size)
+    {
+        if (tail - head >= size)
+            return true;
+
+        // Move the partial record to the start of the buffer and read more
+        memmove(&buffer[0], &buffer[head], tail - head);
+        tail -= head;
+        head = 0;
+        while (tail < size && is.good())
+        {
+            is.read(&buffer[tail], buffer.size() - tail);
+            tail += static_cast<size_t>(is.gcount());
+        }
+        if (tail < size)
+        {
+            // A clean end of stream has no partial record
+            if (tail != 0)
+                error = serialize::ParsingError::END_OF_FILE;
+            return false;
+        }
+        return true;
+    }
+
+    std::istream& is;
+    std::vector<char> buffer;
+    size_t head = 0;
+    size_t tail = 0;
+    uint64_t offset = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_LAYOUT_H
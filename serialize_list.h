@@ -0,0 +1,157 @@
+/// @file serialize_list.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_LIST_H
+#define _SERIALIZE_LIST_H
+
+#include "serialize_core.h"
+#include <list>
+
+/// Serialize a std::list container. The items in list are stored by value.
+template <class T>
+struct serialize_container<std::list<T>>
+{
+    static const bool supported = true;
+
+    /// Write a list container to a stream. The items in list are stored
+    /// by value. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the list container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::list<T>& container)
+    {
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::LIST);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (const auto& item : container) 
+            {
+                ms.write(os, item, false);
+            }
+        }
+        return os;
+    }
+
+    /// Read into a list container from a stream. Items in list are stored 
+    /// by value. 
+    /// @param[in] is - the input stream
+    /// @param[in] container - the list container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::list<T>& container)
+    {
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::LIST))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    T t;
+                    ms.read(is, t, false);
+                    container.push_back(t);
+                }
+            }            
+        }
+        return is;
+    }
+};
+
+/// Serialize a std::list container. The items in list are stored by pointer.
+template <class T>
+struct serialize_container<std::list<T*>>
+{
+    static const bool supported = true;
+
+    /// Write a list container to a stream. The items in list are stored
+    /// by pointer. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the list container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::list<T*>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::LIST);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (auto* ptr : container) 
+            {
+                if (ptr != nullptr) 
+                {
+                    bool notNULL = true;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+
+                    auto* i = static_cast<serialize::I*>(ptr);
+                    ms.write(os, i);
+                }
+                else 
+                {
+                    bool notNULL = false;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+                }
+            }
+        }
+        return os;
+    }
+
+    /// Read into a list container from a stream. Items in list stored
+    /// by pointer. Operator new called to create object instances.
+    /// @param[in] is - the input stream
+    /// @param[in] container - the list container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::list<T*>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::LIST))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    bool notNULL = false;
+                    ms.read_overhead(is, notNULL, serialize::WireBytes::NULL_FLAG);
+                    if (notNULL)
+                    {
+                        if (!ms.charge_allocation(is))
+                            break;
+                        T *object = new T;
+                        auto *i = static_cast<serialize::I*>(object);
+                        ms.read(is, i);
+                        container.push_back(object);
+                    }
+                    else
+                    {
+                        container.push_back(nullptr);
+                    }
+                }
+            }
+        }
+        return is;
+    }
+};
+
+#endif // _SERIALIZE_LIST_H
@@ -0,0 +1,164 @@
+/// @file serialize_map.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_MAP_H
+#define _SERIALIZE_MAP_H
+
+#include "serialize_core.h"
+#include <map>
+
+/// Serialize a std::map container. The items in map are stored by value.
+template <class K, class V, class P>
+struct serialize_container<std::map<K, V, P>>
+{
+    static const bool supported = true;
+
+    /// Write a map container to a stream. The items in map are stored
+    /// by value. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the map container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::map<K, V, P>& container)
+    {
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::MAP);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (const auto& entry : container) 
+            {
+                ms.write(os, entry.first, false);
+                ms.write(os, entry.second, false);
+            }
+        }
+        return os;
+    }
+
+    /// Read into a map container from a stream. Items in map are stored 
+    /// by value. 
+    /// @param[in] is - the input stream
+    /// @param[in] container - the map container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::map<K, V, P>& container)
+    {
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::MAP))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    K key;
+                    V value;
+                    ms.read(is, key, false);
+
+                    ms.read(is, value, false);
+                    container[key] = value;
+                }
+            }
+        }
+        return is;
+    }
+};
+
+/// Serialize a std::map container. The items in map are stored by pointer.
+template <class K, class V, class P>
+struct serialize_container<std::map<K, V*, P>>
+{
+    static const bool supported = true;
+
+    /// Write a map container to a stream. The items in map are stored
+    /// by pointer. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the map container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::map<K, V*, P>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, V>::value, "Type V must be derived from serialize::I");
+
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::MAP);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (auto& entry : container) 
+            {
+                ms.write(os, entry.first, false);
+
+                if (entry.second != nullptr) 
+                {
+                    bool notNULL = true;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+
+                    auto* i = static_cast<serialize::I*>(entry.second);
+                    ms.write(os, i);
+                }
+                else 
+                {
+                    bool notNULL = false;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+                }
+            }
+        }
+        return os;
+    }
+
+    /// Read into a map container from a stream. Items in map stored
+    /// by pointer. Operator new called to create object instances.
+    /// @param[in] is - the input stream
+    /// @param[in] container - the map container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::map<K, V*, P>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, V>::value, "Type V must be derived from serialize::I");
+
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::MAP))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    K key;
+                    ms.read(is, key, false);
+                    bool notNULL;
+                    ms.read_overhead(is, notNULL, serialize::WireBytes::NULL_FLAG);
+                    if (notNULL)
+                    {
+                        if (!ms.charge_allocation(is))
+                            break;
+                        V *object = new V;
+                        auto *i = static_cast<serialize::I*>(object);
+                        ms.read(is, i);
+                        container[key] = (V*) object;
+                    }
+                    else
+                    {
+                        container[key] = nullptr;
+                    }
+                }
+            }
+        }
+        return is;
+    }
+};
+
+#endif // _SERIALIZE_MAP_H
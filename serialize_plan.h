@@ -0,0 +1,310 @@
+/// @file serialize_plan.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_PLAN_H
+#define _SERIALIZE_PLAN_H
+
+#include "serialize_layout.h"
+#include <typeinfo>
+#include <vector>
+
+/// Get the byte offset of a data member within an object.
+/// @param[in] object - the object
+/// @param[in] member - a data member of the object
+/// @return The member byte offset
+template <class C, class M>
+size_t member_offset(const C& object, const M& member)
+{
+    return static_cast<size_t>(reinterpret_cast<const char*>(&member) - reinterpret_cast<const char*>(&object));
+}
+
+/// Binds a type_layout to the data members of a C++ class for a decode_plan.
+/// The arrays are indexed by field and must outlive the plan. e.g.
+///
+/// static const Position instance;
+/// static const size_t offsets[] = { member_offset(instance, instance.latitude), ... };
+/// static const size_t sizes[] = { sizeof(instance.latitude), ... };
+/// static const type_binding binding = { &typeid(Position), &PositionLayout, offsets, sizes, nullptr };
+struct type_binding
+{
+    const std::type_info* type;
+    const type_layout* layout;
+    const size_t* offsets;                  // Byte offset of each field's member
+    const size_t* sizes;                    // sizeof each field's member
+    const type_binding* const* objects;     // Binding of each OBJECT field, otherwise nullptr
+};
+
+/// @brief A decode_plan decodes a user defined object from a buffer by running a
+/// flat array of operations built once from the object's type_binding.
+/// @detail Instead of a virtual I::read() per object and a stream call per field,
+/// one interpreter loop stores each value directly at its member offset. Each run
+/// of consecutive scalar fields is preceded by a RUN operation, so a complete run
+/// needs a single bounds check. Missing fields from an older sender and extra
+/// fields from a newer sender are handled like serialize::read().
+///
+/// Supported fields are scalars, enums, char[], std::string and user defined
+/// objects by value that are themselves supported. Use serialize::read() for other
+/// types; isSupported() is false. The decode budget, wire handler and error
+/// handler of a serialize instance are not used. e.g.
+///
+/// static const decode_plan plan(PositionBinding());
+/// serialize::result r = plan.decode(data, size, position);
+class decode_plan
+{
+public:
+    explicit decode_plan(const type_binding& binding) : type(binding.type)
+    {
+        build(binding, 0, 0);
+    }
+
+    /// Returns true if every field of the type can be decoded by the plan.
+    bool isSupported() const { return supported; }
+
+    /// Get the number of plan operations.
+    size_t getOperations() const { return ops.size(); }
+
+    /// Decode an object from a buffer.
+    /// @param[in] data - the encoded bytes
+    /// @param[in] size - the number of bytes
+    /// @param[out] object - the object to decode into. Must be the bound type.
+    /// @param[in] mode - the wire mode of the encoded bytes
+    /// @return The first error and its byte offset, or the number of bytes decoded.
+    template <class T>
+    serialize::result decode(const char* data, size_t size, T& object,
+        serialize::WireMode mode = serialize::WireMode::TAGGED) const
+    {
+        if (!supported || typeid(T) != *type)
+            return failure(serialize::ParsingError::INVALID_INPUT, 0);
+        return run(data, size, reinterpret_cast<char*>(&object), mode == serialize::WireMode::TAGGED);
+    }
+
+private:
+    enum class Code : uint8_t
+    {
+        OBJECT,     // USER_DEFINED type and size. jump is the index of the END.
+        END,        // Skip any extra data to the end of the object
+        RUN,        // The next count SCALAR operations; bytes total when tagged
+        SCALAR,     // A width byte value stored at offset
+        CSTRING,    // A char array of count bytes at offset
+        STRING      // A std::string at offset
+    };
+
+    struct operation
+    {
+        Code code;
+        uint8_t width;
+        uint16_t count;
+        uint32_t offset;
+        uint32_t jump;
+        uint32_t bytes;
+    };
+
+    struct frame
+    {
+        const char* outerLimit;
+        size_t end;
+    };
+
+    static const uint8_t LITERAL = static_cast<uint8_t>(serialize::Type::LITERAL);
+
+    void build(const type_binding& binding, size_t base, int depth)
+    {
+        if (depth >= serialize::MAX_OBJECT_DEPTH)
+        {
+            supported = false;
+            return;
+        }
+
+        size_t begin = ops.size();
+        push(Code::OBJECT, 0, 0, 0);
+        size_t run = 0;
+        for (size_t i = 0; i < binding.layout->count && supported; i++)
+        {
+            const field_desc& f = binding.layout->fields[i];
+            size_t offset = base + binding.offsets[i];
+            if (is_scalar(f.kind))
+            {
+                // Scalar members must match the encoded width
+                if (binding.sizes[i] != scalar_size(f.kind))
+                {
+                    supported = false;
+                    break;
+                }
+                if (run == 0)
+                {
+                    run = ops.size();
+                    push(Code::RUN, 0, 0, 0);
+                }
+                push(Code::SCALAR, static_cast<uint8_t>(scalar_size(f.kind)), 0, offset);
+                ops[run].count++;
+                ops[run].bytes += static_cast<uint32_t>(1 + scalar_size(f.kind));
+                continue;
+            }
+
+            run = 0;
+            if (f.kind == field_kind::CSTRING)
+                push(Code::CSTRING, 0, static_cast<uint16_t>(binding.sizes[i]), offset);
+            else if (f.kind == field_kind::STRING && binding.sizes[i] == sizeof(std::string))
+                push(Code::STRING, 0, 0, offset);
+            else if (f.kind == field_kind::OBJECT && binding.objects && binding.objects[i])
+                build(*binding.objects[i], offset, depth + 1);
+            else
+                supported = false;
+        }
+        ops[begin].jump = static_cast<uint32_t>(ops.size());
+        push(Code::END, 0, 0, 0);
+    }
+
+    void push(Code code, uint8_t width, uint16_t count, size_t offset)
+    {
+        operation op = { code, width, count, static_cast<uint32_t>(offset), 0, 0 };
+        ops.push_back(op);
+    }
+
+    static serialize::result failure(serialize::ParsingError error, size_t offset)
+    {
+        serialize::result r;
+        r.error = error;
+        r.offset = offset;
+        return r;
+    }
+
+    static uint16_t load_u16(const char* p)
+    {
+        return static_cast<uint16_t>((static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]));
+    }
+
+    /// Store a big endian value in native byte order.
+    static void store(char* dst, const char* src, size_t width)
+    {
+        static const int one = 1;
+        if (*reinterpret_cast<const char*>(&one) == 1)
+        {
+            for (size_t i = 0; i < width; i++)
+                dst[i] = src[width - 1 - i];
+        }
+        else
+        {
+            memcpy(dst, src, width);
+        }
+    }
+
+    serialize::result run(const char* data, size_t size, char* object, bool tagged) const
+    {
+        const char* pos = data;
+        const char* limit = data + size;
+        frame stack[serialize::MAX_OBJECT_DEPTH];
+        int top = 0;
+        const size_t tag = tagged ? 1 : 0;
+
+        size_t i = 0;
+        while (i < ops.size())
+        {
+            const operation& op = ops[i];
+            if (op.code == Code::END)
+            {
+                // Skip over extra data sent by a newer sender
+                pos = limit;
+                limit = stack[--top].outerLimit;
+                i++;
+                continue;
+            }
+            if (top > 0 && pos >= limit)
+            {
+                // Fields missing from an older sender are left unchanged
+                i = stack[top - 1].end;
+                continue;
+            }
+
+            if (op.code == Code::OBJECT)
+            {
+                // Size is measured from the start of the size field
+                if (limit - pos < 3 || static_cast<uint8_t>(pos[0]) != static_cast<uint8_t>(serialize::Type::USER_DEFINED))
+                    return failure(limit - pos < 3 ? serialize::ParsingError::END_OF_FILE : serialize::ParsingError::TYPE_MISMATCH, pos - data);
+                uint16_t objectSize = load_u16(pos + 1);
+                if (objectSize < 2 || static_cast<size_t>(objectSize - 2) > static_cast<size_t>(limit - pos - 3))
+                    return failure(serialize::ParsingError::END_OF_FILE, pos - data);
+                stack[top].outerLimit = limit;
+                stack[top].end = op.jump;
+                top++;
+                limit = pos + 1 + objectSize;
+                pos += 3;
+                i++;
+                continue;
+            }
+
+            switch (op.code)
+            {
+            case Code::RUN:
+            {
+                size_t bytes = tagged ? op.bytes : op.bytes - op.count;
+                if (static_cast<size_t>(limit - pos) < bytes)
+                {
+                    // Not all present; decode each scalar separately
+                    i++;
+                    break;
+                }
+                for (size_t k = 1; k <= op.count; k++)
+                {
+                    const operation& s = ops[i + k];
+                    if (tagged && static_cast<uint8_t>(*pos++) != LITERAL)
+                        return failure(serialize::ParsingError::TYPE_MISMATCH, pos - 1 - data);
+                    store(object + s.offset, pos, s.width);
+                    pos += s.width;
+                }
+                i += 1 + op.count;
+                break;
+            }
+            case Code::SCALAR:
+                if (static_cast<size_t>(limit - pos) < tag + op.width)
+                    return failure(serialize::ParsingError::END_OF_FILE, pos - data);
+                if (tagged && static_cast<uint8_t>(*pos++) != LITERAL)
+                    return failure(serialize::ParsingError::TYPE_MISMATCH, pos - 1 - data);
+                store(object + op.offset, pos, op.width);
+                pos += op.width;
+                i++;
+                break;
+            case Code::CSTRING:
+            case Code::STRING:
+            {
+                if (static_cast<size_t>(limit - pos) < tag + 2)
+                    return failure(serialize::ParsingError::END_OF_FILE, pos - data);
+                if (tagged && static_cast<uint8_t>(*pos++) != static_cast<uint8_t>(serialize::Type::STRING))
+                    return failure(serialize::ParsingError::TYPE_MISMATCH, pos - 1 - data);
+                uint16_t length = load_u16(pos);
+                if (length > serialize::MAX_STRING_SIZE || (op.code == Code::CSTRING && length > op.count))
+                    return failure(serialize::ParsingError::STRING_TOO_LONG, pos - data);
+                pos += 2;
+                if (static_cast<size_t>(limit - pos) < length)
+                    return failure(serialize::ParsingError::END_OF_FILE, pos - data);
+                if (op.code == Code::CSTRING)
+                {
+                    // Terminated like serialize::read(). An empty string leaves the array unchanged, as there.
+                    memcpy(object + op.offset, pos, length);
+                    if (length > 0)
+                        object[op.offset + length - 1] = 0;
+                }
+                else
+                    reinterpret_cast<std::string*>(object + op.offset)->assign(pos, length);
+                pos += length;
+                i++;
+                break;
+            }
+            default:
+                i++;
+                break;
+            }
+        }
+
+        serialize::result r;
+        r.offset = static_cast<size_t>(pos - data);
+        return r;
+    }
+
+    const std::type_info* type;
+    std::vector<operation> ops;
+    bool supported = true;
+};
+
+#endif // _SERIALIZE_PLAN_H
@@ -0,0 +1,435 @@
+/// @file serialize_replica.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_REPLICA_H
+#define _SERIALIZE_REPLICA_H
+
+#include "serialize_core.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+/// Get the length of the whole encoded records at the start of a buffer. Only
+/// the USER_DEFINED type and size of each record are read.
+inline size_t whole_records(const char* data, size_t size)
+{
+    size_t pos = 0;
+    while (size - pos >= 3 && static_cast<serialize::Type>(static_cast<uint8_t>(data[pos])) == serialize::Type::USER_DEFINED)
+    {
+        size_t n = 1 + ((static_cast<uint8_t>(data[pos + 1]) << 8) | static_cast<uint8_t>(data[pos + 2]));
+        if (n < 3 || n > size - pos)
+            break;
+        pos += n;
+    }
+    return pos;
+}
+
+/// @brief The segment_log class is an append-only log of encoded records
+/// stored in segment files.
+/// @detail Segments are named path.000000, path.000001, ... and hold whole
+/// records. A new segment is started when the current one would exceed the
+/// segment size. Records are addressed by their byte offset from the start of
+/// the log. Opening an existing log drops a partial record left at the end by
+/// a crash. Appends are flushed to the OS by flush(). e.g.
+///
+/// segment_log log("alarms.log");
+/// log.append(ms, alarmLog);
+/// log.read(offset, 1 << 20, batch);
+class segment_log
+{
+public:
+    static const size_t MAX_RECORD_SIZE = 1 + 0xFFFF;
+
+    /// Open or create a log.
+    /// @param[in] path - the segment file path prefix
+    /// @param[in] segmentSize - the segment size to roll over at
+    explicit segment_log(const std::string& path_, uint64_t segmentSize_ = 64 * 1024 * 1024) :
+        path(path_), segmentSize(segmentSize_)
+    {
+        open();
+    }
+
+    segment_log(const segment_log&) = delete;
+    segment_log& operator=(const segment_log&) = delete;
+
+    /// Delete the segment files of a log.
+    static void remove(const std::string& path)
+    {
+        for (size_t i = 0; std::remove(segment_name(path, i).c_str()) == 0; i++) {}
+    }
+
+    bool good() const { return error == serialize::ParsingError::NONE; }
+    serialize::ParsingError getLastError() const { return error; }
+
+    /// Get the offset one past the last record.
+    uint64_t getEndOffset() const { return end; }
+
+    /// Get the number of segment files.
+    size_t getSegmentCount() const { return segments.size(); }
+
+    /// Encode a record and append it.
+    template <class T>
+    serialize::result append(serialize& ms, T& record)
+    {
+        serialize::result r = ms.encode(record, scratch);
+        if (r.ok() && !append(scratch.data(), scratch.size()))
+            r.error = good() ? serialize::ParsingError::INVALID_INPUT : error;
+        return r;
+    }
+
+    /// Append whole encoded records.
+    /// @return False if the bytes are not whole records, or the write failed
+    /// (see getLastError()).
+    bool append(const char* data, size_t size)
+    {
+        if (!good())
+            return false;
+        if (whole_records(data, size) != size)
+            return false;
+
+        if (segments.empty() || (segments.back().size > 0 && segments.back().size + size > segmentSize))
+            roll();
+        tail.write(data, static_cast<std::streamsize>(size));
+        if (!tail)
+        {
+            error = serialize::ParsingError::STREAM_ERROR;
+            return false;
+        }
+        segments.back().size += size;
+        end += size;
+        dirty = true;
+        return true;
+    }
+
+    /// Flush appended records to the OS.
+    void flush()
+    {
+        if (dirty)
+            tail.flush();
+        dirty = false;
+    }
+
+    /// Read whole records from the segment files, up to the end of a segment.
+    /// @param[in] offset - the offset of a record
+    /// @param[in] maxBytes - the maximum bytes to read, at least MAX_RECORD_SIZE
+    /// @param[out] out - the records are appended
+    /// @return False if the offset is not at a record or the read failed. At the
+    /// end offset nothing is appended and true is returned.
+    bool read(uint64_t offset, size_t maxBytes, std::vector<char>& out)
+    {
+        if (offset >= end)
+            return offset == end;
+
+        size_t index = 0;
+        while (index + 1 < segments.size() && segments[index + 1].base <= offset)
+            index++;
+        if (index + 1 == segments.size())
+            flush();
+
+        if (readIndex != index || !reader.is_open())
+        {
+            reader.close();
+            reader.open(segment_name(path, index), std::ios::binary);
+            readIndex = index;
+        }
+
+        const segment& s = segments[index];
+        uint64_t available = s.base + s.size - offset;
+        if (maxBytes < MAX_RECORD_SIZE)
+            maxBytes = MAX_RECORD_SIZE;
+        size_t n = available < maxBytes ? static_cast<size_t>(available) : maxBytes;
+
+        size_t start = out.size();
+        out.resize(start + n);
+        reader.clear();
+        reader.seekg(static_cast<std::streamoff>(offset - s.base));
+        reader.read(&out[start], static_cast<std::streamsize>(n));
+        if (static_cast<size_t>(reader.gcount()) != n)
+        {
+            out.resize(start);
+            return false;
+        }
+
+        size_t whole = whole_records(&out[start], n);
+        out.resize(start + whole);
+        return whole > 0;
+    }
+
+private:
+    struct segment
+    {
+        uint64_t base;
+        uint64_t size;
+    };
+
+    static std::string segment_name(const std::string& path, size_t index)
+    {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%06u", static_cast<unsigned>(index));
+        return path + suffix;
+    }
+
+    void open()
+    {
+        for (size_t i = 0;; i++)
+        {
+            std::ifstream f(segment_name(path, i), std::ios::binary | std::ios::ate);
+            if (!f)
+                break;
+            segment s = { end, static_cast<uint64_t>(f.tellg()) };
+            segments.push_back(s);
+            end += s.size;
+        }
+        if (segments.empty())
+            return;
+
+        recover();
+        tail.open(segment_name(path, segments.size() - 1), std::ios::binary | std::ios::app);
+        if (!tail)
+            error = serialize::ParsingError::STREAM_ERROR;
+    }
+
+    /// Drop a partial record at the end of the last segment.
+    void recover()
+    {
+        segment& s = segments.back();
+        std::string name = segment_name(path, segments.size() - 1);
+        std::ifstream f(name, std::ios::binary);
+        std::vector<char> chunk(1 << 20);
+        uint64_t valid = 0;
+        while (valid < s.size)
+        {
+            size_t n = s.size - valid < chunk.size() ? static_cast<size_t>(s.size - valid) : chunk.size();
+            f.seekg(static_cast<std::streamoff>(valid));
+            f.read(chunk.data(), static_cast<std::streamsize>(n));
+            size_t whole = f ? whole_records(chunk.data(), n) : 0;
+            if (whole == 0)
+                break;
+            valid += whole;
+        }
+        if (valid == s.size)
+            return;
+
+        // Truncated in place, so the segment exists at every moment
+        f.close();
+        if (!truncate_file(name, valid))
+            error = serialize::ParsingError::STREAM_ERROR;
+        end -= s.size - valid;
+        s.size = valid;
+    }
+
+    static bool truncate_file(const std::string& name, uint64_t size)
+    {
+#ifdef _WIN32
+        int fd = -1;
+        if (_sopen_s(&fd, name.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+            return false;
+        bool ok = _chsize_s(fd, static_cast<__int64>(size)) == 0;
+        _close(fd);
+        return ok;
+#else
+        return ::truncate(name.c_str(), static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    void roll()
+    {
+        tail.close();
+        segment s = { end, 0 };
+        segments.push_back(s);
+        tail.open(segment_name(path, segments.size() - 1), std::ios::binary | std::ios::trunc);
+        if (!tail)
+            error = serialize::ParsingError::STREAM_ERROR;
+    }
+
+    std::string path;
+    uint64_t segmentSize;
+    std::vector<segment> segments;
+    uint64_t end = 0;
+    std::ofstream tail;
+    bool dirty = false;
+    std::ifstream reader;
+    size_t readIndex = 0;
+    std::vector<char> scratch;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+/// @brief Replication message format shared by log_leader and log_follower.
+/// @detail Each message is, big endian:
+///
+///     u8 kind, u64 log offset, [records if DATA]
+///
+/// HELLO carries the follower's log end offset when it connects, DATA a batch
+/// of whole records starting at the offset, and ACK the follower's log end
+/// offset after appending. The transport must deliver whole messages, e.g. the
+/// frames of serialize_frame.h over a local socket.
+struct replication
+{
+    static const size_t HEADER_SIZE = 9;
+
+    enum class Kind : uint8_t { HELLO = 1, DATA = 2, ACK = 3 };
+
+    typedef std::function<void(const char* data, size_t size)> SendHandler;
+
+    static void put_header(std::vector<char>& out, Kind kind, uint64_t offset)
+    {
+        out.resize(HEADER_SIZE);
+        out[0] = static_cast<char>(kind);
+        for (int i = 0; i < 8; i++)
+            out[1 + i] = static_cast<char>(offset >> (8 * (7 - i)));
+    }
+
+    static uint64_t load_offset(const char* p)
+    {
+        uint64_t value = 0;
+        for (int i = 1; i <= 8; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+};
+
+/// @brief The log_leader class streams a segment_log to one follower.
+/// @detail Records are sent as they are stored, without decoding, in batches
+/// read from the segment files by offset. The same path serves newly appended
+/// records, read back through the OS page cache, and a follower catching up
+/// after a disconnect. At most the window of unacknowledged bytes is in flight.
+/// e.g.
+///
+/// log_leader leader(log, [&](const char* data, size_t size) { send_frame(sock, data, size); });
+/// leader.receive(data, size);     // HELLO or ACK from the follower
+/// log.append(ms, alarmLog);
+/// leader.pump();
+class log_leader
+{
+public:
+    /// @param[in] log - the leader's log. Must outlive the leader.
+    /// @param[in] handler - sends one replication message
+    /// @param[in] batchBytes - the maximum record bytes per DATA message
+    /// @param[in] window - the maximum unacknowledged bytes
+    log_leader(segment_log& log_, replication::SendHandler handler_,
+        size_t batchBytes_ = 1024 * 1024, uint64_t window_ = 8 * 1024 * 1024) :
+        log(log_), handler(handler_), batchBytes(batchBytes_), window(window_) {}
+
+    /// Handle a HELLO or ACK message and send what the window allows.
+    /// @return False if the message is invalid.
+    bool receive(const char* data, size_t size)
+    {
+        if (size != replication::HEADER_SIZE)
+            return false;
+        uint64_t offset = replication::load_offset(data);
+        replication::Kind kind = static_cast<replication::Kind>(data[0]);
+        if (kind == replication::Kind::HELLO && offset <= log.getEndOffset())
+        {
+            // Resume from the follower's end
+            connected = true;
+            next = acked = offset;
+        }
+        else if (kind == replication::Kind::ACK && connected && offset <= next)
+            acked = offset > acked ? offset : acked;
+        else
+            return false;
+        pump();
+        return true;
+    }
+
+    /// Send records appended since the last send, within the window. Call after
+    /// appending to the log.
+    void pump()
+    {
+        while (connected && next < log.getEndOffset() && next - acked < window)
+        {
+            replication::put_header(message, replication::Kind::DATA, next);
+            if (!log.read(next, batchBytes, message) || message.size() == replication::HEADER_SIZE)
+                break;
+            next += message.size() - replication::HEADER_SIZE;
+            handler(message.data(), message.size());
+        }
+    }
+
+    /// Stop sending until the next HELLO.
+    void disconnect() { connected = false; }
+
+    /// Get the follower's acknowledged log end offset.
+    uint64_t getAcked() const { return acked; }
+
+private:
+    segment_log& log;
+    replication::SendHandler handler;
+    size_t batchBytes;
+    uint64_t window;
+    bool connected = false;
+    uint64_t next = 0;
+    uint64_t acked = 0;
+    std::vector<char> message;
+};
+
+/// @brief The log_follower class appends the records streamed by a log_leader
+/// to its own segment_log and acknowledges them.
+/// @detail Batches already appended, e.g. resent after a reconnect, are
+/// skipped. e.g.
+///
+/// log_follower follower(log, [&](const char* data, size_t size) { send_frame(sock, data, size); });
+/// follower.connect();             // After each connect
+/// follower.receive(data, size);   // DATA from the leader
+class log_follower
+{
+public:
+    /// @param[in] log - the follower's log. Must outlive the follower.
+    /// @param[in] handler - sends one replication message
+    log_follower(segment_log& log_, replication::SendHandler handler_) :
+        log(log_), handler(handler_) {}
+
+    /// Send HELLO with the log end offset to start or resume replication.
+    void connect() { send(replication::Kind::HELLO); }
+
+    /// Append a DATA message and acknowledge it.
+    /// @return False if the message is invalid, leaves a gap in the log or
+    /// the append failed. Reconnect to resume.
+    bool receive(const char* data, size_t size)
+    {
+        if (size < replication::HEADER_SIZE || static_cast<replication::Kind>(data[0]) != replication::Kind::DATA)
+            return false;
+
+        uint64_t offset = replication::load_offset(data);
+        uint64_t count = size - replication::HEADER_SIZE;
+        uint64_t end = log.getEndOffset();
+        if (offset > end)
+            return false;
+
+        // Skip records already appended
+        if (offset + count > end)
+        {
+            size_t skip = static_cast<size_t>(end - offset);
+            if (!log.append(data + replication::HEADER_SIZE + skip, static_cast<size_t>(count) - skip))
+                return false;
+            log.flush();
+        }
+        send(replication::Kind::ACK);
+        return true;
+    }
+
+private:
+    void send(replication::Kind kind)
+    {
+        replication::put_header(message, kind, log.getEndOffset());
+        handler(message.data(), message.size());
+    }
+
+    segment_log& log;
+    replication::SendHandler handler;
+    std::vector<char> message;
+};
+
+#endif // _SERIALIZE_REPLICA_H
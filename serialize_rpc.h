@@ -0,0 +1,281 @@
+/// @file serialize_rpc.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_RPC_H
+#define _SERIALIZE_RPC_H
+
+#include "serialize_core.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @brief RPC message header and status codes shared by rpc_client and rpc_server.
+/// @detail Each RPC message is a header followed by the encoded request or
+/// response object, big endian:
+///
+///     u8 kind, u8 status, u16 method id, u32 correlation id, object
+///
+/// The transport must deliver whole messages, e.g. datagrams or the frames of
+/// serialize_frame.h over a stream.
+struct rpc
+{
+    static const size_t HEADER_SIZE = 8;
+
+    enum class Kind : uint8_t { REQUEST = 1, RESPONSE = 2 };
+
+    enum class Status : uint8_t
+    {
+        OK,
+        UNKNOWN_METHOD,     // The server has no handler for the method
+        BAD_REQUEST,        // The server could not decode the request
+        BAD_RESPONSE,       // The response could not be encoded or decoded
+        DISCONNECTED        // The call was cancelled by rpc_client::close()
+    };
+
+    typedef std::function<void(const char* data, size_t size)> SendHandler;
+
+    /// Encode an object after an RPC header.
+    /// @return The encode result. On error only the header is written.
+    template <class T>
+    static serialize::result encode(serialize& ms, Kind kind, Status status, uint16_t method, uint32_t id,
+        T& object, std::vector<char>& out)
+    {
+        serialize::result r = ms.encode(object, out);
+        if (r.ok())
+            out.insert(out.begin(), HEADER_SIZE, 0);
+        else
+            out.resize(HEADER_SIZE);
+        put_header(out.data(), kind, status, method, id);
+        return r;
+    }
+
+    static void put_header(char* p, Kind kind, Status status, uint16_t method, uint32_t id)
+    {
+        p[0] = static_cast<char>(kind);
+        p[1] = static_cast<char>(status);
+        p[2] = static_cast<char>(method >> 8);
+        p[3] = static_cast<char>(method);
+        for (int i = 0; i < 4; i++)
+            p[4 + i] = static_cast<char>(id >> (8 * (3 - i)));
+    }
+
+    static uint32_t load(const char* p, size_t bytes)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < bytes; i++)
+            value = (value << 8) | static_cast<uint8_t>(p[i]);
+        return value;
+    }
+};
+
+/// The status and response object of a completed call.
+template <class Resp>
+struct rpc_reply
+{
+    rpc::Status status = rpc::Status::DISCONNECTED;
+    Resp response;
+
+    bool ok() const { return status == rpc::Status::OK; }
+};
+
+/// @brief The rpc_client class makes pipelined calls over one connection.
+/// @detail Any number of calls may be in flight. Each call gets a correlation
+/// id and an entry in the completion table; the response may arrive in any
+/// order and completes the call's callback or future. No thread is used per
+/// call. call() is thread safe. receive() is called by the one thread reading
+/// the connection, and callbacks run on that thread. e.g.
+///
+/// rpc_client client([&](const char* data, size_t size) { send_frame(sock, data, size); });
+/// std::future<rpc_reply<Date>> f = client.call<Date>(GET_ALARM_DATE, alarmLog);
+/// ...
+/// client.receive(data, size);         // Response received by the reader thread
+/// rpc_reply<Date> reply = f.get();
+class rpc_client
+{
+public:
+    /// @param[in] handler - sends one RPC message
+    explicit rpc_client(rpc::SendHandler handler_) : handler(handler_) {}
+
+    /// Pending calls complete with DISCONNECTED.
+    ~rpc_client() { close(); }
+
+    rpc_client(const rpc_client&) = delete;
+    rpc_client& operator=(const rpc_client&) = delete;
+
+    /// Call a method and complete a callback with the response.
+    /// @param[in] method - the method id
+    /// @param[in] request - the request object
+    /// @param[in] callback - called once with the status and response
+    /// @return The request encode result. The callback is not called on error.
+    template <class Resp, class Req>
+    serialize::result call(uint16_t method, Req& request, std::function<void(rpc::Status, Resp&)> callback)
+    {
+        std::vector<char> out;
+        serialize::result r;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uint32_t id = ++lastId;
+            r = rpc::encode(encoder, rpc::Kind::REQUEST, rpc::Status::OK, method, id, request, out);
+            if (!r.ok())
+                return r;
+            pending[id] = [this, callback](rpc::Status status, const char* data, size_t size)
+            {
+                Resp response;
+                if (status == rpc::Status::OK && !decoder.decode(data, size, response).ok())
+                    status = rpc::Status::BAD_RESPONSE;
+                callback(status, response);
+            };
+        }
+        handler(out.data(), out.size());
+        return r;
+    }
+
+    /// Call a method and get a future of the reply.
+    /// @return The reply future. A request that fails to encode completes
+    /// with BAD_REQUEST.
+    template <class Resp, class Req>
+    std::future<rpc_reply<Resp>> call(uint16_t method, Req& request)
+    {
+        std::shared_ptr<std::promise<rpc_reply<Resp>>> promise = std::make_shared<std::promise<rpc_reply<Resp>>>();
+        std::future<rpc_reply<Resp>> future = promise->get_future();
+        serialize::result r = call<Resp>(method, request, std::function<void(rpc::Status, Resp&)>(
+            [promise](rpc::Status status, Resp& response)
+            {
+                rpc_reply<Resp> reply;
+                reply.status = status;
+                reply.response = std::move(response);
+                promise->set_value(std::move(reply));
+            }));
+        if (!r.ok())
+        {
+            rpc_reply<Resp> reply;
+            reply.status = rpc::Status::BAD_REQUEST;
+            promise->set_value(std::move(reply));
+        }
+        return future;
+    }
+
+    /// Complete the call matching a received response message.
+    /// @return False if the message is not a response to a pending call.
+    bool receive(const char* data, size_t size)
+    {
+        if (size < rpc::HEADER_SIZE || static_cast<rpc::Kind>(data[0]) != rpc::Kind::RESPONSE)
+            return false;
+
+        Completion completion;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = pending.find(rpc::load(data + 4, 4));
+            if (it == pending.end())
+                return false;
+            completion = std::move(it->second);
+            pending.erase(it);
+        }
+        completion(static_cast<rpc::Status>(data[1]), data + rpc::HEADER_SIZE, size - rpc::HEADER_SIZE);
+        return true;
+    }
+
+    /// Complete all pending calls with DISCONNECTED, e.g. when the connection closes.
+    void close()
+    {
+        std::unordered_map<uint32_t, Completion> cancelled;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelled.swap(pending);
+        }
+        for (auto& c : cancelled)
+            c.second(rpc::Status::DISCONNECTED, nullptr, 0);
+    }
+
+    /// Get the number of calls awaiting a response.
+    size_t getPending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+private:
+    typedef std::function<void(rpc::Status status, const char* data, size_t size)> Completion;
+
+    rpc::SendHandler handler;
+    mutable std::mutex mutex;
+    serialize encoder;
+    serialize decoder;
+    uint32_t lastId = 0;
+    std::unordered_map<uint32_t, Completion> pending;
+};
+
+/// @brief The rpc_server class decodes requests, calls the bound method
+/// handler and sends the response with the request's correlation id.
+/// @detail Requests are handled in the order received by the thread calling
+/// receive(). e.g.
+///
+/// rpc_server server([&](const char* data, size_t size) { send_frame(sock, data, size); });
+/// server.bind<AlarmLog, Date>(GET_ALARM_DATE, [](AlarmLog& log, Date& date) { date = log.date; });
+/// server.receive(data, size);
+class rpc_server
+{
+public:
+    /// @param[in] handler - sends one RPC message
+    explicit rpc_server(rpc::SendHandler handler_) : handler(handler_) {}
+
+    /// Bind a method id to a handler that fills in the response.
+    template <class Req, class Resp>
+    void bind(uint16_t method, std::function<void(Req&, Resp&)> function)
+    {
+        methods[method] = [this, function](uint16_t m, uint32_t id, const char* data, size_t size)
+        {
+            Req request;
+            Resp response;
+            if (!ms.decode(data, size, request).ok())
+            {
+                respond(rpc::Status::BAD_REQUEST, m, id);
+                return;
+            }
+            function(request, response);
+            if (rpc::encode(ms, rpc::Kind::RESPONSE, rpc::Status::OK, m, id, response, out).ok())
+                handler(out.data(), out.size());
+            else
+                respond(rpc::Status::BAD_RESPONSE, m, id);
+        };
+    }
+
+    /// Handle a received request message.
+    /// @return False if the message is not a request.
+    bool receive(const char* data, size_t size)
+    {
+        if (size < rpc::HEADER_SIZE || static_cast<rpc::Kind>(data[0]) != rpc::Kind::REQUEST)
+            return false;
+
+        uint16_t method = static_cast<uint16_t>(rpc::load(data + 2, 2));
+        uint32_t id = rpc::load(data + 4, 4);
+        auto it = methods.find(method);
+        if (it == methods.end())
+            respond(rpc::Status::UNKNOWN_METHOD, method, id);
+        else
+            it->second(method, id, data + rpc::HEADER_SIZE, size - rpc::HEADER_SIZE);
+        return true;
+    }
+
+private:
+    typedef std::function<void(uint16_t method, uint32_t id, const char* data, size_t size)> Method;
+
+    void respond(rpc::Status status, uint16_t method, uint32_t id)
+    {
+        out.resize(rpc::HEADER_SIZE);
+        rpc::put_header(out.data(), rpc::Kind::RESPONSE, status, method, id);
+        handler(out.data(), out.size());
+    }
+
+    rpc::SendHandler handler;
+    serialize ms;
+    std::vector<char> out;
+    std::unordered_map<uint16_t, Method> methods;
+};
+
+#endif // _SERIALIZE_RPC_H
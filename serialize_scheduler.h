@@ -0,0 +1,220 @@
+/// @file serialize_scheduler.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_SCHEDULER_H
+#define _SERIALIZE_SCHEDULER_H
+
+#include "serialize_core.h"
+#include "serialize_coalesce.h"
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/// @brief The message_scheduler class sends messages of several priority lanes
+/// over one connection, interleaving large messages in chunks.
+/// @detail Lane 0 has the highest priority. Each sendNext() sends one chunk of
+/// the oldest message in the highest priority lane with pending data, so a new
+/// high priority message waits for at most one chunk of a large low priority
+/// message. Lower lanes are sent only when higher lanes are empty. Each chunk
+/// is prefixed with a header, big endian:
+///
+///     u8 lane, u8 flags (LAST on the final chunk of a message), u16 payload size
+///
+/// A chunk_assembler rebuilds the messages. The scheduler has no thread; the
+/// caller's event loop calls sendNext() while the connection is writable. e.g.
+///
+/// message_scheduler scheduler([&](const char* data, size_t size) { sock.send(data, size); }, 2);
+/// scheduler.enqueue(ms, allData, BULK_LANE);
+/// scheduler.enqueue(ms, alarmLog, ALARM_LANE);
+/// while (sock.writable() && scheduler.sendNext()) {}
+class message_scheduler
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> SendHandler;
+    typedef std::chrono::steady_clock clock;
+
+    static const size_t HEADER_SIZE = 4;
+    static const uint8_t LAST = 0x01;
+
+    /// @param[in] handler - sends one chunk
+    /// @param[in] lanes - the number of priority lanes, up to 256
+    /// @param[in] chunkSize - the maximum payload bytes per chunk, up to 65535
+    message_scheduler(SendHandler handler_, size_t lanes, size_t chunkSize_ = 1024) :
+        handler(handler_), queues(lanes), latency(lanes),
+        chunkSize(chunkSize_ == 0 ? 1 : chunkSize_ > 0xFFFF ? 0xFFFF : chunkSize_)
+    {
+        chunk.reserve(HEADER_SIZE + chunkSize);
+    }
+
+    /// Encode a message into a lane.
+    /// @return The encode result. Nothing is queued on error.
+    template <class T>
+    serialize::result enqueue(serialize& ms, T& message, size_t lane)
+    {
+        pending p;
+        serialize::result r = ms.encode(message, p.bytes);
+        if (r.ok())
+            push(lane, p);
+        return r;
+    }
+
+    /// Queue an encoded message into a lane.
+    void enqueue(const char* data, size_t size, size_t lane)
+    {
+        pending p;
+        p.bytes.assign(data, data + size);
+        push(lane, p);
+    }
+
+    /// Send the next chunk.
+    /// @return False if no message is pending.
+    bool sendNext()
+    {
+        for (size_t lane = 0; lane < queues.size(); lane++)
+        {
+            if (queues[lane].empty())
+                continue;
+
+            pending& p = queues[lane].front();
+            size_t n = p.bytes.size() - p.sent;
+            n = n < chunkSize ? n : chunkSize;
+            bool last = p.sent + n == p.bytes.size();
+
+            chunk.resize(HEADER_SIZE + n);
+            chunk[0] = static_cast<char>(lane);
+            chunk[1] = static_cast<char>(last ? LAST : 0);
+            chunk[2] = static_cast<char>(n >> 8);
+            chunk[3] = static_cast<char>(n);
+            if (n > 0)
+                memcpy(&chunk[HEADER_SIZE], p.bytes.data() + p.sent, n);
+            p.sent += n;
+            handler(chunk.data(), chunk.size());
+
+            if (last)
+            {
+                clock::duration delay = clock::now() - p.enqueued;
+                latency[lane].record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count()));
+                queues[lane].pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /// Send all pending chunks.
+    void flush()
+    {
+        while (sendNext()) {}
+    }
+
+    /// Get the number of messages pending in a lane.
+    size_t getPending(size_t lane) const { return queues[lane].size(); }
+
+    /// Get the time from enqueue to the last chunk sent of each message in a
+    /// lane, in nanoseconds.
+    const latency_histogram& getLatency(size_t lane) const { return latency[lane]; }
+
+private:
+    struct pending
+    {
+        std::vector<char> bytes;
+        size_t sent = 0;
+        clock::time_point enqueued;
+    };
+
+    void push(size_t lane, pending& p)
+    {
+        lane = lane < queues.size() ? lane : queues.size() - 1;
+        p.enqueued = clock::now();
+        queues[lane].push_back(std::move(p));
+    }
+
+    SendHandler handler;
+    std::vector<std::deque<pending>> queues;
+    std::vector<latency_histogram> latency;
+    size_t chunkSize;
+    std::vector<char> chunk;
+};
+
+/// @brief The chunk_assembler class rebuilds messages from the chunks sent by
+/// a message_scheduler.
+/// @detail Stream bytes may arrive split at any point. Each lane has one
+/// message in progress. A message larger than the maximum size or a chunk for
+/// an unknown lane is a protocol error; the connection should be closed. e.g.
+///
+/// chunk_assembler assembler([&](size_t lane, const char* data, size_t size) { ms.decode(data, size, ...); }, 2);
+/// if (!assembler.receive(data, size))
+///     sock.close();
+class chunk_assembler
+{
+public:
+    typedef std::function<void(size_t lane, const char* data, size_t size)> MessageHandler;
+
+    /// @param[in] handler - called with each complete message
+    /// @param[in] lanes - the number of priority lanes
+    /// @param[in] maxMessage - the maximum message size in bytes
+    chunk_assembler(MessageHandler handler_, size_t lanes, size_t maxMessage_ = 1024 * 1024) :
+        handler(handler_), messages(lanes), maxMessage(maxMessage_) {}
+
+    /// Add received stream bytes. Complete messages are passed to the handler.
+    /// @return False on a protocol error. See getLastError().
+    bool receive(const char* data, size_t size)
+    {
+        while (good())
+        {
+            if (headerFill < message_scheduler::HEADER_SIZE)
+            {
+                size_t n = message_scheduler::HEADER_SIZE - headerFill;
+                n = n < size ? n : size;
+                memcpy(header + headerFill, data, n);
+                headerFill += n;
+                data += n;
+                size -= n;
+                if (headerFill < message_scheduler::HEADER_SIZE)
+                    break;
+
+                lane = static_cast<uint8_t>(header[0]);
+                remaining = (static_cast<uint8_t>(header[2]) << 8) | static_cast<uint8_t>(header[3]);
+                if (lane >= messages.size())
+                    error = serialize::ParsingError::INVALID_INPUT;
+                else if (messages[lane].size() + remaining > maxMessage)
+                    error = serialize::ParsingError::BUDGET_EXCEEDED;
+                if (!good())
+                    break;
+            }
+
+            size_t n = remaining < size ? remaining : size;
+            messages[lane].insert(messages[lane].end(), data, data + n);
+            data += n;
+            size -= n;
+            remaining -= n;
+            if (remaining > 0)
+                break;
+
+            headerFill = 0;
+            if (static_cast<uint8_t>(header[1]) & message_scheduler::LAST)
+            {
+                handler(lane, messages[lane].data(), messages[lane].size());
+                messages[lane].clear();
+            }
+        }
+        return good();
+    }
+
+    bool good() const { return error == serialize::ParsingError::NONE; }
+    serialize::ParsingError getLastError() const { return error; }
+
+private:
+    MessageHandler handler;
+    std::vector<std::vector<char>> messages;
+    size_t maxMessage;
+    char header[message_scheduler::HEADER_SIZE] = { 0 };
+    size_t headerFill = 0;
+    size_t lane = 0;
+    size_t remaining = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_SCHEDULER_H
@@ -0,0 +1,199 @@
+/// @file serialize_schema.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_SCHEMA_H
+#define _SERIALIZE_SCHEMA_H
+
+#include "serialize_layout.h"
+#include <string>
+#include <vector>
+
+/// An enclosing layout while computing a fingerprint, used to detect recursive types.
+struct schema_ancestor
+{
+    const type_layout* layout;
+    const schema_ancestor* parent;
+};
+
+/// FNV-1a hash of one byte.
+constexpr uint64_t schema_hash_byte(uint64_t hash, uint8_t byte)
+{
+    return (hash ^ byte) * 1099511628211ull;
+}
+
+/// Hash the wire structure of a layout. Field and type names are not hashed
+/// since renaming does not change the encoding.
+constexpr uint64_t schema_hash(uint64_t hash, const type_layout& layout, const schema_ancestor* parent)
+{
+    // A recursive type hashes a reference to the enclosing layout
+    uint8_t back = 0;
+    for (const schema_ancestor* a = parent; a != nullptr; a = a->parent, back++)
+    {
+        if (a->layout == &layout)
+            return schema_hash_byte(schema_hash_byte(hash, 0xFF), back);
+    }
+
+    schema_ancestor self{ &layout, parent };
+    hash = schema_hash_byte(hash, 0xFE);
+    for (size_t i = 0; i < layout.count; i++)
+    {
+        const field_desc& f = layout.fields[i];
+        hash = schema_hash_byte(hash, static_cast<uint8_t>(f.kind));
+        hash = schema_hash_byte(hash, static_cast<uint8_t>(f.key));
+        hash = schema_hash_byte(hash, static_cast<uint8_t>(f.element));
+        if (f.object != nullptr)
+            hash = schema_hash(hash, *f.object, &self);
+    }
+    return schema_hash_byte(hash, 0xFD);
+}
+
+/// Compute a compile time fingerprint of a type's wire layout, including
+/// nested object layouts. Equal fingerprints mean two peers encode the type
+/// identically. e.g.
+///
+/// constexpr uint64_t AlarmLogFingerprint = schema_fingerprint(AlarmLogLayout);
+constexpr uint64_t schema_fingerprint(const type_layout& layout)
+{
+    return schema_hash(14695981039346656037ull, layout, nullptr);
+}
+
+/// @brief The schema_handshake class agrees on a wire mode per message type.
+/// @detail Each peer registers its message type layouts and the wire modes it
+/// supports, then sends its hello message. After receiving the other peer's hello,
+/// each type uses the fastest mode both peers support if the type fingerprints
+/// match. Otherwise, or for types unknown to the peer, the type falls back to
+/// serialize::WireMode::TAGGED. Both peers reach the same decision. e.g.
+///
+/// schema_handshake hs;
+/// hs.add(AlarmLogLayout);
+/// hs.writeHello(hello);                       // Send to peer
+/// hs.readHello(peerHello, peerHelloSize);     // Received from peer
+/// ms.setWireMode(hs.getMode(AlarmLogLayout));
+/// ms.write(os, alarmLog);
+///
+/// Types are matched by type_layout name. The hello message encodes a version,
+/// a uint16 type count and for each type the name length (uint8), name,
+/// fingerprint (uint64) and supported modes (uint8 bit mask), big endian.
+class schema_handshake
+{
+public:
+    /// Mode bit mask of a single wire mode
+    static uint8_t modeBit(serialize::WireMode mode) { return static_cast<uint8_t>(1 << static_cast<int>(mode)); }
+
+    static const uint8_t ALL_MODES = 0x03;
+
+    /// Register a local message type. TAGGED is always supported.
+    /// @param[in] layout - the type layout. Must outlive the handshake.
+    /// @param[in] modes - the supported wire modes bit mask
+    void add(const type_layout& layout, uint8_t modes = ALL_MODES)
+    {
+        entry e;
+        e.layout = &layout;
+        e.fingerprint = schema_fingerprint(layout);
+        e.modes = modes | modeBit(serialize::WireMode::TAGGED);
+        types.push_back(e);
+    }
+
+    /// Write the local hello message.
+    /// @param[out] out - the hello message bytes
+    void writeHello(std::vector<char>& out) const
+    {
+        out.clear();
+        put(out, VERSION, 1);
+        put(out, types.size(), 2);
+        for (const entry& e : types)
+        {
+            size_t len = strlen(e.layout->name);
+            len = len > 0xFF ? 0xFF : len;
+            put(out, len, 1);
+            out.insert(out.end(), e.layout->name, e.layout->name + len);
+            put(out, e.fingerprint, 8);
+            put(out, e.modes, 1);
+        }
+    }
+
+    /// Read the peer's hello message and choose the wire mode of each type.
+    /// @param[in] data - the hello message bytes
+    /// @param[in] size - the number of bytes
+    /// @return True if the hello message was parsed. On failure all types use TAGGED.
+    bool readHello(const char* data, size_t size)
+    {
+        for (entry& e : types)
+            e.mode = serialize::WireMode::TAGGED;
+
+        wire_reader reader(data, size);
+        if (reader.readU8() != VERSION)
+            reader.fail(serialize::ParsingError::INVALID_INPUT);
+
+        std::vector<entry> agreed(types);
+        uint16_t count = reader.readU16();
+        for (uint16_t i = 0; i < count && reader.good(); i++)
+        {
+            uint8_t len = reader.readU8();
+            const char* name = reader.readBytes(len);
+            uint64_t fingerprint = reader.readBits(8);
+            uint8_t modes = reader.readU8();
+            if (!reader.good())
+                break;
+
+            for (entry& e : agreed)
+            {
+                if (strlen(e.layout->name) == len && memcmp(e.layout->name, name, len) == 0 &&
+                    e.fingerprint == fingerprint)
+                    e.mode = fastest(e.modes & modes);
+            }
+        }
+
+        error = reader.getLastError();
+        if (reader.good())
+            types.swap(agreed);
+        return reader.good();
+    }
+
+    /// Get the agreed wire mode of a type.
+    /// @param[in] layout - the registered type layout
+    /// @return The wire mode, or TAGGED if the type is not registered or not agreed.
+    serialize::WireMode getMode(const type_layout& layout) const
+    {
+        for (const entry& e : types)
+        {
+            if (e.layout == &layout)
+                return e.mode;
+        }
+        return serialize::WireMode::TAGGED;
+    }
+
+    serialize::ParsingError getLastError() const { return error; }
+
+private:
+    static const uint8_t VERSION = 1;
+
+    struct entry
+    {
+        const type_layout* layout = nullptr;
+        uint64_t fingerprint = 0;
+        uint8_t modes = 0;
+        serialize::WireMode mode = serialize::WireMode::TAGGED;
+    };
+
+    /// Get the fastest wire mode within a mode bit mask. Higher modes are faster.
+    static serialize::WireMode fastest(uint8_t modes)
+    {
+        if (modes & modeBit(serialize::WireMode::UNTAGGED))
+            return serialize::WireMode::UNTAGGED;
+        return serialize::WireMode::TAGGED;
+    }
+
+    /// Append a big endian value of 1 to 8 bytes.
+    static void put(std::vector<char>& out, uint64_t value, size_t size)
+    {
+        for (size_t i = size; i > 0; i--)
+            out.push_back(static_cast<char>(value >> (8 * (i - 1))));
+    }
+
+    std::vector<entry> types;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+};
+
+#endif // _SERIALIZE_SCHEMA_H
@@ -0,0 +1,212 @@
+/// @file serialize_set.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_SET_H
+#define _SERIALIZE_SET_H
+
+#include "serialize_core.h"
+#include <algorithm>
+#include <set>
+
+/// Serialize a std::set container. The items in set are stored by value.
+template <class T, class P>
+struct serialize_container<std::set<T, P>>
+{
+    static const bool supported = true;
+
+    /// Write a set container to a stream. The items in set are stored
+    /// by value. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the set container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::set<T, P>& container)
+    {
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::SET);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (const auto& item : container) 
+            {
+                ms.write(os, item, false);
+            }
+        }
+        return os;
+    }
+
+    /// Read into a set container from a stream. Items in set are stored 
+    /// by value. 
+    /// @param[in] is - the input stream
+    /// @param[in] container - the set container to read into
+    /// @return The input stream   
+    static std::istream& read(serialize& ms, std::istream& is, std::set<T, P>& container)
+    {
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::SET))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    T t;
+                    ms.read(is, t, false);
+                    container.insert(t);
+                }
+            }
+        }
+        return is;
+    }
+};
+
+/// Serialize a std::set container. The items in set are stored by pointer.
+template <class T, class P>
+struct serialize_container<std::set<T*, P>>
+{
+    static const bool supported = true;
+
+    /// Write a set container to a stream. The items in set are stored
+    /// by pointer. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the set container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::set<T*, P>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::SET);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            if (ms.canonical)
+            {
+                for (auto ptr : canonical_order(ms, container))
+                    write_element(ms, os, ptr);
+            }
+            else
+            {
+                for (auto ptr : container)
+                    write_element(ms, os, ptr);
+            }
+        }
+        return os;
+    }
+
+    static void write_element(serialize& ms, std::ostream& os, T* ptr)
+    {
+        if (ptr != nullptr)
+        {
+            bool notNULL = true;
+            ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+
+            auto* i = static_cast<serialize::I*>(ptr);
+            ms.write(os, i);
+        }
+        else
+        {
+            bool notNULL = false;
+            ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+        }
+    }
+
+    /// Get the set elements ordered by their encoded bytes. Pointer order
+    /// differs between runs, so canonical encoding cannot use it.
+    static std::vector<T*> canonical_order(serialize& ms, std::set<T*, P>& container)
+    {
+        std::vector<std::pair<std::vector<char>, T*>> encoded;
+        encoded.reserve(container.size());
+
+        // Element encodings are not reported to the wire handler
+        serialize::IWireHandler* handler = ms.wire_handler;
+        ms.wire_handler = nullptr;
+        for (auto ptr : container)
+        {
+            encoded.emplace_back(std::vector<char>(), ptr);
+            if (ptr != nullptr)
+            {
+                serialize::memory_streambuf buf(encoded.back().first);
+                std::ostream os(&buf);
+                auto* i = static_cast<serialize::I*>(ptr);
+                ms.write(os, i);
+                buf.finish();
+            }
+        }
+        ms.wire_handler = handler;
+
+        // A null element has no encoding and sorts first
+        std::sort(encoded.begin(), encoded.end(),
+            [](const std::pair<std::vector<char>, T*>& a, const std::pair<std::vector<char>, T*>& b)
+            {
+                if (a.first.empty() != b.first.empty())
+                    return a.first.empty();
+
+                // Compare as unsigned bytes on every platform
+                size_t n = std::min(a.first.size(), b.first.size());
+                int c = n ? memcmp(a.first.data(), b.first.data(), n) : 0;
+                return c != 0 ? c < 0 : a.first.size() < b.first.size();
+            });
+
+        std::vector<T*> ordered;
+        ordered.reserve(encoded.size());
+        for (auto& e : encoded)
+            ordered.push_back(e.second);
+        return ordered;
+    }
+
+    /// Read into a set container from a stream. Items in set stored
+    /// by pointer. Operator new called to create object instances.
+    /// @param[in] is - the input stream
+    /// @param[in] container - the set container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::set<T*, P>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::SET))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    bool notNULL = false;
+                    ms.read_overhead(is, notNULL, serialize::WireBytes::NULL_FLAG);
+                    if (notNULL)
+                    {
+                        if (!ms.charge_allocation(is))
+                            break;
+                        T *object = new T;
+                        auto *i = static_cast<serialize::I*>(object);
+                        ms.read(is, i);
+                        container.insert(object);
+                    }
+                    else
+                    {
+                        container.insert(nullptr);
+                    }
+                }
+            }
+        }
+        return is;
+    }
+};
+
+#endif // _SERIALIZE_SET_H
@@ -0,0 +1,210 @@
+/// @file serialize_snapshot.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_SNAPSHOT_H
+#define _SERIALIZE_SNAPSHOT_H
+
+#include "serialize_core.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// @brief The snapshot_cell class holds a copy-on-write state object so that
+/// readers get a consistent snapshot without blocking writers.
+/// @detail A published object is never modified. update() copies the current
+/// object, applies the change to the copy without holding the read lock, and
+/// then flips the current pointer. Readers hold the lock only to copy the
+/// pointer, and a snapshot stays valid while the reader holds it, however many
+/// updates follow. Updates are serialized with each other. A type that cannot
+/// be copied, e.g. one owning raw pointers, is built by the writer and passed
+/// to publish(). e.g.
+///
+/// snapshot_cell<AlarmLog> state;
+/// state.update([](AlarmLog& log) { log.alarmValue++; });    // Writer
+/// std::shared_ptr<const AlarmLog> snap = state.snapshot();  // Reader
+template <class T>
+class snapshot_cell
+{
+public:
+    snapshot_cell() : current(std::make_shared<T>()) {}
+
+    /// @param[in] initial - the initial state. Must not be null.
+    explicit snapshot_cell(std::shared_ptr<T> initial) : current(std::move(initial)) {}
+
+    snapshot_cell(const snapshot_cell&) = delete;
+    snapshot_cell& operator=(const snapshot_cell&) = delete;
+
+    /// Get the current state. The object must not be modified.
+    std::shared_ptr<const T> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(pointerMutex);
+        return current;
+    }
+
+    /// Copy the current state, change the copy and publish it.
+    /// @param[in] change - called with the copy, e.g. void(T&)
+    template <class F>
+    void update(F change)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        std::shared_ptr<T> next = std::make_shared<T>(*current);
+        change(*next);
+        flip(std::move(next));
+    }
+
+    /// Publish a new state object. Must not be null.
+    void publish(std::shared_ptr<T> next)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        flip(std::move(next));
+    }
+
+    /// Get the number of states published.
+    uint64_t getVersion() const
+    {
+        std::lock_guard<std::mutex> lock(pointerMutex);
+        return version;
+    }
+
+private:
+    void flip(std::shared_ptr<T> next)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pointerMutex);
+            current.swap(next);
+            version++;
+        }
+        // The previous state is released here, outside the lock, if no reader holds it
+    }
+
+    mutable std::mutex pointerMutex;
+    std::mutex writeMutex;
+    std::shared_ptr<T> current;
+    uint64_t version = 0;
+};
+
+/// @brief The snapshot_encoder class encodes snapshots of a snapshot_cell on a
+/// background thread.
+/// @detail request() returns at once. The thread takes the current snapshot
+/// and encodes it with its own serialize instance, so writers are paused only
+/// for the pointer flip and never for the encode. Requests made while an encode
+/// is in progress are coalesced into one encode of the latest state. The
+/// handler is called on the background thread. e.g.
+///
+/// snapshot_encoder<AlarmLog> encoder(state, [&](const char* data, size_t size) { send(data, size); });
+/// encoder.request();
+template <class T>
+class snapshot_encoder
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> EncodeHandler;
+
+    /// @param[in] cell - the state to encode. Must outlive the encoder.
+    /// @param[in] handler - called with each encoded snapshot
+    snapshot_encoder(const snapshot_cell<T>& cell_, EncodeHandler handler_) :
+        cell(cell_), handler(handler_), thread(&snapshot_encoder::run, this) {}
+
+    /// Finishes a requested encode, then stops the thread.
+    ~snapshot_encoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        signal.notify_all();
+        thread.join();
+    }
+
+    snapshot_encoder(const snapshot_encoder&) = delete;
+    snapshot_encoder& operator=(const snapshot_encoder&) = delete;
+
+    /// Request an encode of the current state.
+    void request()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (requested)
+                coalesced++;
+            requested = true;
+        }
+        signal.notify_all();
+    }
+
+    /// Wait until all requests are encoded.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        signal.wait(lock, [this]() { return !requested && !encoding; });
+    }
+
+    /// Get the number of snapshots encoded.
+    uint64_t getEncoded() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return encoded;
+    }
+
+    /// Get the number of requests merged into another request's encode.
+    uint64_t getCoalesced() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return coalesced;
+    }
+
+    /// Get the error of the last encode. The handler is not called on error.
+    serialize::ParsingError getLastError() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return error;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            signal.wait(lock, [this]() { return requested || stopping; });
+            if (!requested)
+                return;
+            requested = false;
+            encoding = true;
+            lock.unlock();
+
+            // A published object is never modified, and write() does not modify it either
+            std::shared_ptr<const T> snap = cell.snapshot();
+            serialize::result r = ms.encode(const_cast<T&>(*snap), out);
+            snap.reset();
+            if (r.ok())
+                handler(out.data(), out.size());
+
+            lock.lock();
+            encoding = false;
+            error = r.error;
+            if (r.ok())
+                encoded++;
+            signal.notify_all();
+        }
+    }
+
+    const snapshot_cell<T>& cell;
+    EncodeHandler handler;
+    serialize ms;
+    std::vector<char> out;
+    mutable std::mutex mutex;
+    std::condition_variable signal;
+    bool requested = false;
+    bool encoding = false;
+    bool stopping = false;
+    uint64_t encoded = 0;
+    uint64_t coalesced = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+    std::thread thread;
+};
+
+#endif // _SERIALIZE_SNAPSHOT_H
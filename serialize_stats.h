@@ -0,0 +1,247 @@
+/// @file serialize_stats.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_STATS_H
+#define _SERIALIZE_STATS_H
+
+#include "serialize_core.h"
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+/// @brief The wire_stats class reports where encoded message bytes are spent.
+/// @detail Each analyzed message is encoded or decoded with an internal serialize
+/// instance and the bytes are split into type tags, length prefixes, null flags,
+/// user defined sizes and payload. Bytes are attributed per type and per field
+/// (the field index within the user defined object write()/read() order).
+/// Results accumulate over all analyzed messages, so analyzing a traffic sample
+/// shows where dropping tags or adding codecs pays off. e.g.
+///
+/// wire_stats stats;
+/// stats.analyze(alarmLog);                        // From an object
+/// stats.analyze<AlarmLog>(buf, size);             // From an encoded buffer
+/// stats.print(std::cout);
+class wire_stats : public serialize::IWireHandler
+{
+public:
+    static const int CATEGORIES = static_cast<int>(serialize::WireBytes::SKIPPED) + 1;
+
+    /// Byte counts by wire category
+    struct counts
+    {
+        uint64_t bytes[CATEGORIES] = { 0 };
+
+        uint64_t& operator[](serialize::WireBytes category) { return bytes[static_cast<int>(category)]; }
+        uint64_t operator[](serialize::WireBytes category) const { return bytes[static_cast<int>(category)]; }
+
+        /// Bytes spent on framing instead of payload
+        uint64_t overhead() const { return total() - (*this)[serialize::WireBytes::PAYLOAD]; }
+
+        uint64_t total() const
+        {
+            uint64_t sum = 0;
+            for (int i = 0; i < CATEGORIES; i++)
+                sum += bytes[i];
+            return sum;
+        }
+    };
+
+    /// Byte counts for one user defined type
+    struct type_stats
+    {
+        uint64_t objects = 0;           // Number of objects of this type
+        counts bytes;                   // Bytes of all fields
+        std::vector<counts> fields;     // Bytes per field index
+    };
+
+    /// Name of the pseudo-type holding the top-level object framing
+    static const char* rootName() { return "(message)"; }
+
+    wire_stats()
+    {
+        ms.setWireHandler(this);
+    }
+
+    wire_stats(const wire_stats&) = delete;
+    wire_stats& operator=(const wire_stats&) = delete;
+
+    /// Encode an object and accumulate its wire statistics.
+    /// @param[in] obj - the object to analyze
+    /// @return The encoded message size in bytes
+    template <typename T>
+    size_t analyze(T& obj)
+    {
+        std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+        begin_message();
+        ms.write(ss, obj);
+        return end_message(ss.good());
+    }
+
+    /// Decode an encoded buffer into a T and accumulate its wire statistics.
+    /// @param[in] data - the encoded message bytes
+    /// @param[in] size - the number of bytes
+    /// @return The number of bytes parsed, or 0 if the message failed to parse
+    template <typename T>
+    size_t analyze(const char* data, size_t size)
+    {
+        std::istringstream is(std::string(data, size), std::ios::in | std::ios::binary);
+        T obj;
+        begin_message();
+        ms.read(is, obj);
+        return end_message(is.good());
+    }
+
+    /// Get the accumulated statistics keyed by type name.
+    const std::map<std::string, type_stats>& getTypes() const { return typeStats; }
+
+    /// Get the accumulated byte counts of all messages.
+    const counts& getTotals() const { return totalBytes; }
+
+    /// Get the number of messages analyzed.
+    uint64_t getMessages() const { return messageCount; }
+
+    /// Get the number of messages that failed to encode or decode.
+    uint64_t getErrors() const { return errorCount; }
+
+    /// Get the message size histogram. Bucket N counts messages with a
+    /// size in the range [2^N, 2^(N+1)) bytes.
+    const std::vector<uint64_t>& getHistogram() const { return sizeHistogram; }
+
+    /// Discard all accumulated statistics.
+    void clear()
+    {
+        typeStats.clear();
+        totalBytes = counts();
+        sizeHistogram.clear();
+        messageCount = 0;
+        errorCount = 0;
+    }
+
+    /// Output a human readable report.
+    /// @param[in] os - the output stream
+    void print(std::ostream& os) const
+    {
+        os << "Messages: " << messageCount << " Errors: " << errorCount << "\n";
+        os << "Size histogram:\n";
+        for (size_t i = 0; i < sizeHistogram.size(); i++)
+        {
+            if (sizeHistogram[i])
+                os << "  [" << (1ull << i) << ", " << (1ull << (i + 1)) << ") " << sizeHistogram[i] << "\n";
+        }
+
+        os << std::left << std::setw(28) << "Type/field" << std::right;
+        for (int i = 0; i < CATEGORIES; i++)
+            os << std::setw(10) << categoryName(static_cast<serialize::WireBytes>(i));
+        os << std::setw(10) << "total" << "\n";
+
+        print_row(os, "(all)", totalBytes);
+        for (const auto& type : typeStats)
+        {
+            print_row(os, type.first + " x" + std::to_string(type.second.objects), type.second.bytes);
+            for (size_t i = 0; i < type.second.fields.size(); i++)
+                print_row(os, "  [" + std::to_string(i) + "]", type.second.fields[i]);
+        }
+    }
+
+    /// Get a short name for a wire category.
+    static const char* categoryName(serialize::WireBytes category)
+    {
+        switch (category)
+        {
+        case serialize::WireBytes::TYPE_TAG: return "tag";
+        case serialize::WireBytes::LENGTH_PREFIX: return "length";
+        case serialize::WireBytes::NULL_FLAG: return "null";
+        case serialize::WireBytes::USER_DEFINED_SIZE: return "size";
+        case serialize::WireBytes::PAYLOAD: return "payload";
+        case serialize::WireBytes::SKIPPED: return "skipped";
+        }
+        return "?";
+    }
+
+    virtual void wireBegin(const std::type_info& typeId) override
+    {
+        type_stats& stats = typeStats[typeId.name()];
+        stats.objects++;
+        frameStack.push_back(frame{ &stats, -1 });
+    }
+
+    virtual void wireEnd() override
+    {
+        if (frameStack.size() > 1)
+            frameStack.pop_back();
+    }
+
+    virtual void wireField() override
+    {
+        frame& top = frameStack.back();
+        top.field++;
+        if (top.stats->fields.size() <= static_cast<size_t>(top.field))
+            top.stats->fields.resize(top.field + 1);
+    }
+
+    virtual void wireBytes(serialize::WireBytes category, size_t size) override
+    {
+        frame& top = frameStack.back();
+        top.stats->bytes[category] += size;
+        if (top.field >= 0)
+            top.stats->fields[top.field][category] += size;
+        totalBytes[category] += size;
+        messageSize += size;
+    }
+
+private:
+    struct frame
+    {
+        type_stats* stats;
+        int field;
+    };
+
+    void begin_message()
+    {
+        frameStack.clear();
+        type_stats& stats = typeStats[rootName()];
+        stats.objects++;
+        frameStack.push_back(frame{ &stats, -1 });
+        messageSize = 0;
+    }
+
+    size_t end_message(bool ok)
+    {
+        messageCount++;
+        if (!ok)
+        {
+            errorCount++;
+            return 0;
+        }
+
+        size_t bucket = 0;
+        while ((messageSize >> (bucket + 1)) != 0)
+            bucket++;
+        if (sizeHistogram.size() <= bucket)
+            sizeHistogram.resize(bucket + 1);
+        sizeHistogram[bucket]++;
+        return static_cast<size_t>(messageSize);
+    }
+
+    static void print_row(std::ostream& os, const std::string& name, const counts& c)
+    {
+        os << std::left << std::setw(28) << name << std::right;
+        for (int i = 0; i < CATEGORIES; i++)
+            os << std::setw(10) << c.bytes[i];
+        os << std::setw(10) << c.total() << "\n";
+    }
+
+    serialize ms;
+    std::map<std::string, type_stats> typeStats;
+    std::vector<frame> frameStack;
+    counts totalBytes;
+    std::vector<uint64_t> sizeHistogram;
+    uint64_t messageSize = 0;
+    uint64_t messageCount = 0;
+    uint64_t errorCount = 0;
+};
+
+#endif // _SERIALIZE_STATS_H
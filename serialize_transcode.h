@@ -0,0 +1,511 @@
+/// @file serialize_transcode.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_TRANSCODE_H
+#define _SERIALIZE_TRANSCODE_H
+
+#include "serialize_layout.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/// @brief The transcoder class converts encoded objects directly to CSV or JSON text.
+/// @detail The encoded bytes are walked using the object's type_layout; no objects
+/// are created. An archive of consecutive encoded objects is streamed in large
+/// chunks and the text output is buffered, so export runs near disk speed.
+///
+/// CSV output has one row per object. Nested objects are flattened into columns
+/// named "field.nested" and container fields are a single JSON array cell.
+/// JSON output has one JSON object per line (JSON Lines). Fields missing from an
+/// older sender are empty (CSV) or null (JSON). e.g.
+///
+/// transcoder tc(AlarmLogLayout, transcoder::Format::CSV);
+/// tc.transcode(archiveFile, csvFile);
+class transcoder
+{
+public:
+    enum class Format { CSV, JSON };
+
+    transcoder(const type_layout& layout_, Format format_) : layout(layout_), format(format_)
+    {
+        out.reserve(FLUSH_SIZE + 1024);
+    }
+
+    /// Transcode all encoded objects within an archive stream. A CSV header
+    /// row is output first.
+    /// @param[in] archive - the input stream of encoded objects
+    /// @param[in] os - the text output stream
+    /// @return True if all objects were transcoded.
+    bool transcode(std::istream& archive, std::ostream& os)
+    {
+        if (format == Format::CSV)
+            header(os);
+
+        record_reader records(archive);
+        const char* data = nullptr;
+        size_t size = 0;
+        bool ok = true;
+        while (ok && records.next(data, size))
+        {
+            uint64_t offset = records.getOffset() - size;
+            ok = record(data, size, offset);
+            flush(os, false);
+        }
+        flush(os, true);
+        if (ok && records.getLastError() != serialize::ParsingError::NONE)
+        {
+            error = records.getLastError();
+            errorOffset = records.getOffset();
+            ok = false;
+        }
+        return ok;
+    }
+
+    /// Transcode one encoded object.
+    /// @param[in] data - the encoded object bytes
+    /// @param[in] size - the number of bytes
+    /// @param[in] os - the text output stream
+    /// @return True if the object was transcoded.
+    bool transcode(const char* data, size_t size, std::ostream& os)
+    {
+        bool ok = record(data, size, 0);
+        flush(os, true);
+        return ok;
+    }
+
+    /// Output the CSV header row of column names.
+    void header(std::ostream& os)
+    {
+        bool first = true;
+        header_columns(layout, std::string(), first);
+        out += '\n';
+        flush(os, true);
+    }
+
+    /// Get the number of objects transcoded.
+    uint64_t getRecords() const { return records; }
+
+    /// Get the first error and the byte offset where it occurred.
+    serialize::ParsingError getLastError() const { return error; }
+    uint64_t getErrorOffset() const { return errorOffset; }
+
+    // layout_walker visitor interface
+    void beginObject(const type_layout&)
+    {
+        if (json())
+        {
+            value();
+            out += '{';
+            first.push_back(true);
+        }
+    }
+
+    void endObject(const type_layout&)
+    {
+        if (json())
+        {
+            out += '}';
+            first.pop_back();
+        }
+    }
+
+    void beginField(const field_desc& f)
+    {
+        if (json())
+            name(f);
+        else if (f.kind != field_kind::OBJECT)
+            column();
+    }
+
+    void endField(const field_desc&) {}
+
+    void missingField(const field_desc& f)
+    {
+        if (json())
+        {
+            name(f);
+            out += "null";
+            skipSeparator = false;
+        }
+        else
+        {
+            // One empty cell per flattened column
+            size_t n = f.kind == field_kind::OBJECT ? columns(*f.object) : 1;
+            for (size_t i = 0; i < n; i++)
+                column();
+        }
+    }
+
+    void scalar(field_kind kind, uint64_t bits)
+    {
+        if (!json())
+        {
+            format_scalar(kind, bits);
+            return;
+        }
+
+        // A map key is always a JSON string
+        value();
+        if (mapKey)
+            quote();
+        format_scalar(kind, bits);
+        if (mapKey)
+            quote();
+    }
+
+    void string(field_kind kind, const char* data, size_t size)
+    {
+        if (kind == field_kind::CSTRING)
+            size = strnlen(data, size);
+
+        if (json())
+            value();
+        quote();
+        if (kind == field_kind::WSTRING)
+        {
+            // UTF-16 surrogate pairs become one 4-byte UTF-8 sequence. A lone
+            // surrogate is not valid UTF-8 and is replaced with U+FFFD.
+            for (size_t i = 0; i + 1 < size; i += serialize::WCHAR_SIZE)
+            {
+                unsigned c = utf16(data + i);
+                if (c >= 0xD800 && c <= 0xDBFF && i + 3 < size && utf16(data + i + 2) >= 0xDC00 && utf16(data + i + 2) <= 0xDFFF)
+                {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (utf16(data + i + 2) - 0xDC00);
+                    i += serialize::WCHAR_SIZE;
+                }
+                else if (c >= 0xD800 && c <= 0xDFFF)
+                {
+                    c = 0xFFFD;
+                }
+                utf8(c);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < size; i++)
+                character(data[i]);
+        }
+        quote();
+    }
+
+    void beginContainer(const field_desc& f, size_t)
+    {
+        // A top-level CSV container is one quoted cell
+        if (json())
+            value();
+        else
+            out += '"';
+        cellDepth++;
+
+        out += f.kind == field_kind::MAP ? '{' : '[';
+        first.push_back(true);
+        maps.push_back(f.kind == field_kind::MAP);
+    }
+
+    void endContainer(const field_desc& f)
+    {
+        first.pop_back();
+        maps.pop_back();
+        out += f.kind == field_kind::MAP ? '}' : ']';
+        if (--cellDepth == 0 && format == Format::CSV)
+            out += '"';
+    }
+
+    void beginElement(size_t)
+    {
+        comma();
+        skipSeparator = true;
+        mapKey = maps.back();
+    }
+
+    void mapValue()
+    {
+        out += ':';
+        skipSeparator = true;
+        mapKey = false;
+    }
+
+    void nullObject()
+    {
+        value();
+        out += "null";
+    }
+
+private:
+    static const size_t FLUSH_SIZE = 1 << 16;
+
+    bool json() const { return format == Format::JSON || cellDepth > 0; }
+
+    bool record(const char* data, size_t size, uint64_t offset)
+    {
+        wire_reader reader(data, size);
+        layout_walker<transcoder> walker(reader, *this);
+        first.clear();
+        maps.clear();
+        cellDepth = 0;
+        rowStart = true;
+        skipSeparator = false;
+        mapKey = false;
+
+        size_t rowBegin = out.size();
+        if (!walker.object(layout))
+        {
+            // Discard the partial row
+            out.resize(rowBegin);
+            error = reader.getLastError();
+            errorOffset = offset + reader.offset();
+            return false;
+        }
+        out += '\n';
+        records++;
+        return true;
+    }
+
+    void flush(std::ostream& os, bool force)
+    {
+        if (force || out.size() >= FLUSH_SIZE)
+        {
+            os.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+
+    /// Output a comma between JSON values unless first in the object or container
+    void comma()
+    {
+        if (!first.empty())
+        {
+            if (!first.back())
+                out += ',';
+            first.back() = false;
+        }
+    }
+
+    /// Called before each JSON value. Values following a name, map key or
+    /// element start are not separated.
+    void value()
+    {
+        if (skipSeparator)
+            skipSeparator = false;
+        else
+            comma();
+    }
+
+    void name(const field_desc& f)
+    {
+        comma();
+        quote();
+        out += f.name;
+        quote();
+        out += ':';
+        skipSeparator = true;
+    }
+
+    /// Output a comma between CSV columns
+    void column()
+    {
+        if (!rowStart)
+            out += ',';
+        rowStart = false;
+    }
+
+    /// Output a double quote. Within a CSV cell JSON quotes are doubled.
+    void quote()
+    {
+        out += '"';
+        if (format == Format::CSV && cellDepth > 0)
+            out += '"';
+    }
+
+    void character(char c)
+    {
+        if (!json())
+        {
+            // CSV quoted text only escapes quotes
+            if (c == '"')
+                out += '"';
+            out += c;
+            return;
+        }
+
+        switch (c)
+        {
+        case '"':
+            out += '\\';
+            quote();
+            return;
+        case '\\': out += "\\\\"; return;
+        case '\n': out += "\\n"; return;
+        case '\r': out += "\\r"; return;
+        case '\t': out += "\\t"; return;
+        default: break;
+        }
+        if (static_cast<uint8_t>(c) < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+            out += buf;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+
+    static unsigned utf16(const char* p)
+    {
+        return (static_cast<uint8_t>(p[0]) << 8) | static_cast<uint8_t>(p[1]);
+    }
+
+    void utf8(unsigned c)
+    {
+        if (c < 0x80)
+        {
+            character(static_cast<char>(c));
+        }
+        else if (c < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    void format_scalar(field_kind kind, uint64_t bits)
+    {
+        switch (kind)
+        {
+        case field_kind::BOOL:
+            out += bits ? "true" : "false";
+            return;
+        case field_kind::FLOAT:
+        {
+            uint32_t b = static_cast<uint32_t>(bits);
+            float f;
+            memcpy(&f, &b, sizeof(f));
+            format_real(f, "%.9g");
+            return;
+        }
+        case field_kind::DOUBLE:
+        {
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            format_real(d, "%.17g");
+            return;
+        }
+        default:
+            break;
+        }
+
+        if (is_signed(kind))
+        {
+            // Sign extend to 64-bits
+            unsigned shift = static_cast<unsigned>(64 - 8 * scalar_size(kind));
+            int64_t v = static_cast<int64_t>(bits << shift) >> shift;
+            if (v < 0)
+            {
+                out += '-';
+                format_uint(0 - static_cast<uint64_t>(v));
+                return;
+            }
+        }
+        format_uint(bits);
+    }
+
+    /// Format an unsigned integer two digits at a time
+    void format_uint(uint64_t v)
+    {
+        static const char digits[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char buf[20];
+        char* p = buf + sizeof(buf);
+        while (v >= 100)
+        {
+            unsigned i = static_cast<unsigned>(v % 100) * 2;
+            v /= 100;
+            *--p = digits[i + 1];
+            *--p = digits[i];
+        }
+        if (v >= 10)
+        {
+            unsigned i = static_cast<unsigned>(v) * 2;
+            *--p = digits[i + 1];
+            *--p = digits[i];
+        }
+        else
+        {
+            *--p = static_cast<char>('0' + v);
+        }
+        out.append(p, buf + sizeof(buf) - p);
+    }
+
+    void format_real(double d, const char* fmt)
+    {
+        if (d != d || d - d != 0)
+        {
+            // NaN and infinity have no JSON representation
+            out += "null";
+            return;
+        }
+        char buf[32];
+        int n = snprintf(buf, sizeof(buf), fmt, d);
+        out.append(buf, static_cast<size_t>(n));
+    }
+
+    /// Get the number of flattened CSV columns of a layout.
+    static size_t columns(const type_layout& l)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < l.count; i++)
+            n += l.fields[i].kind == field_kind::OBJECT ? columns(*l.fields[i].object) : 1;
+        return n;
+    }
+
+    void header_columns(const type_layout& l, const std::string& prefix, bool& firstColumn)
+    {
+        for (size_t i = 0; i < l.count; i++)
+        {
+            const field_desc& f = l.fields[i];
+            if (f.kind == field_kind::OBJECT)
+            {
+                header_columns(*f.object, prefix + f.name + ".", firstColumn);
+                continue;
+            }
+            if (!firstColumn)
+                out += ',';
+            firstColumn = false;
+            out += prefix;
+            out += f.name;
+        }
+    }
+
+    const type_layout& layout;
+    Format format;
+    std::string out;
+    std::vector<bool> first;
+    std::vector<bool> maps;
+    int cellDepth = 0;
+    bool rowStart = true;
+    bool skipSeparator = false;
+    bool mapKey = false;
+    uint64_t records = 0;
+    serialize::ParsingError error = serialize::ParsingError::NONE;
+    uint64_t errorOffset = 0;
+};
+
+#endif // _SERIALIZE_TRANSCODE_H
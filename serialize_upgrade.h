@@ -0,0 +1,207 @@
+/// @file serialize_upgrade.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_UPGRADE_H
+#define _SERIALIZE_UPGRADE_H
+
+#include "serialize_schema.h"
+#include <vector>
+
+/// @brief The version_upgrader class converts encoded records of one message
+/// version to a newer version without decoding them.
+/// @detail The newer version must only append fields to the older version. Each
+/// record is copied, the default encoding of the new fields is appended and the
+/// USER_DEFINED size is rewritten. The appended bytes are built once, so an
+/// upgrade costs a copy per record. New scalar fields default to zero, strings
+/// and containers to empty and objects to their own defaults. e.g.
+///
+/// version_upgrader upgrader(DataV1Layout, DataV2Layout);
+/// std::vector<char> out;
+/// serialize::result r = upgrader.upgrade(archive, archiveSize, out);
+///
+/// The records must be encoded from the older version. If the older version
+/// has a fixed encoded size, each record size is checked.
+class version_upgrader
+{
+public:
+    /// Constructor.
+    /// @param[in] from - the older version layout
+    /// @param[in] to - the newer version layout
+    /// @param[in] mode - the wire mode of the records
+    version_upgrader(const type_layout& from, const type_layout& to,
+        serialize::WireMode mode = serialize::WireMode::TAGGED) :
+        tagged(mode == serialize::WireMode::TAGGED)
+    {
+        supported = to.count >= from.count;
+        for (size_t i = 0; i < from.count && supported; i++)
+            supported = same_field(from.fields[i], to.fields[i]);
+        for (size_t i = from.count; i < to.count && supported; i++)
+            supported = append_default(tail, to.fields[i], 0);
+        fixedSize = fixed_size(from, 0);
+    }
+
+    /// Returns true if the newer version only appends fields.
+    bool isSupported() const { return supported; }
+
+    /// Get the number of bytes appended to each record.
+    size_t getAppendedSize() const { return tail.size(); }
+
+    /// Upgrade one or more consecutive records.
+    /// @param[in] data - the encoded records of the older version
+    /// @param[in] size - the number of bytes
+    /// @param[out] out - the upgraded records are appended
+    /// @return The first error and the byte offset of its record, or the number
+    /// of bytes read. On error out holds the records upgraded before the error.
+    serialize::result upgrade(const char* data, size_t size, std::vector<char>& out) const
+    {
+        serialize::result r;
+        if (!supported)
+        {
+            r.error = serialize::ParsingError::INVALID_INPUT;
+            return r;
+        }
+
+        while (r.offset < size)
+        {
+            const char* record = data + r.offset;
+            size_t remaining = size - r.offset;
+            if (remaining < 3)
+            {
+                r.error = serialize::ParsingError::END_OF_FILE;
+                return r;
+            }
+            if (static_cast<uint8_t>(record[0]) != static_cast<uint8_t>(serialize::Type::USER_DEFINED))
+            {
+                r.error = serialize::ParsingError::TYPE_MISMATCH;
+                return r;
+            }
+
+            // Size is measured from the start of the size field
+            size_t objectSize = wire_load<uint16_t>(record + 1);
+            if (objectSize < 2 || objectSize + 1 > remaining)
+            {
+                r.error = serialize::ParsingError::END_OF_FILE;
+                return r;
+            }
+            if ((fixedSize != 0 && objectSize + 1 != fixedSize) || objectSize + tail.size() > 0xFFFF)
+            {
+                r.error = serialize::ParsingError::INVALID_INPUT;
+                return r;
+            }
+
+            size_t start = out.size();
+            out.insert(out.end(), record, record + objectSize + 1);
+            out.insert(out.end(), tail.begin(), tail.end());
+            put_u16(&out[start + 1], objectSize + tail.size());
+            r.offset += objectSize + 1;
+        }
+        return r;
+    }
+
+private:
+    static void put_u16(char* p, size_t value)
+    {
+        p[0] = static_cast<char>(value >> 8);
+        p[1] = static_cast<char>(value);
+    }
+
+    static bool same_field(const field_desc& a, const field_desc& b)
+    {
+        if (a.kind != b.kind || a.key != b.key || a.element != b.element)
+            return false;
+        if (a.object == nullptr || b.object == nullptr)
+            return a.object == b.object;
+        return schema_fingerprint(*a.object) == schema_fingerprint(*b.object);
+    }
+
+    void append_type(std::vector<char>& out, serialize::Type type) const
+    {
+        if (tagged || type == serialize::Type::USER_DEFINED)
+            out.push_back(static_cast<char>(type));
+    }
+
+    /// Append the encoding of a default constructed field.
+    bool append_default(std::vector<char>& out, const field_desc& f, int depth) const
+    {
+        if (is_scalar(f.kind))
+        {
+            append_type(out, serialize::Type::LITERAL);
+            out.insert(out.end(), scalar_size(f.kind), 0);
+            return true;
+        }
+
+        switch (f.kind)
+        {
+        case field_kind::STRING:
+        case field_kind::WSTRING:
+            append_type(out, f.kind == field_kind::STRING ? serialize::Type::STRING : serialize::Type::WSTRING);
+            out.insert(out.end(), 2, 0);
+            return true;
+        case field_kind::CSTRING:
+            // An empty string includes the terminating null
+            append_type(out, serialize::Type::STRING);
+            out.push_back(0);
+            out.push_back(1);
+            out.push_back(0);
+            return true;
+        case field_kind::VECTOR:
+        case field_kind::LIST:
+        case field_kind::SET:
+        case field_kind::MAP:
+            append_type(out, f.kind == field_kind::VECTOR ? serialize::Type::VECTOR :
+                f.kind == field_kind::LIST ? serialize::Type::LIST :
+                f.kind == field_kind::SET ? serialize::Type::SET : serialize::Type::MAP);
+            out.insert(out.end(), 2, 0);
+            return true;
+        case field_kind::OBJECT:
+        {
+            if (f.object == nullptr || depth >= serialize::MAX_OBJECT_DEPTH)
+                return false;
+            size_t start = out.size();
+            append_type(out, serialize::Type::USER_DEFINED);
+            out.insert(out.end(), 2, 0);
+            for (size_t i = 0; i < f.object->count; i++)
+            {
+                if (!append_default(out, f.object->fields[i], depth + 1))
+                    return false;
+            }
+            if (out.size() - start - 1 > 0xFFFF)
+                return false;
+            put_u16(&out[start + 1], out.size() - start - 1);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    /// Get the encoded size of a layout with only scalars and fixed size
+    /// objects, otherwise 0.
+    size_t fixed_size(const type_layout& layout, int depth) const
+    {
+        if (depth >= serialize::MAX_OBJECT_DEPTH)
+            return 0;
+
+        // USER_DEFINED type and size
+        size_t size = 3;
+        for (size_t i = 0; i < layout.count; i++)
+        {
+            const field_desc& f = layout.fields[i];
+            if (is_scalar(f.kind))
+                size += (tagged ? 1 : 0) + scalar_size(f.kind);
+            else if (f.kind == field_kind::OBJECT && f.object != nullptr && fixed_size(*f.object, depth + 1) != 0)
+                size += fixed_size(*f.object, depth + 1);
+            else
+                return 0;
+        }
+        return size;
+    }
+
+    bool tagged;
+    bool supported = false;
+    size_t fixedSize = 0;
+    std::vector<char> tail;
+};
+
+#endif // _SERIALIZE_UPGRADE_H
@@ -0,0 +1,222 @@
+/// @file serialize_vector.h
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+
+#ifndef _SERIALIZE_VECTOR_H
+#define _SERIALIZE_VECTOR_H
+
+#include "serialize_core.h"
+#include <vector>
+
+/// Serialize a std::vector container. The items in vector are stored by value.
+template <class T>
+struct serialize_container<std::vector<T>>
+{
+    static const bool supported = true;
+
+    /// Write a vector container to a stream. The items in vector are stored
+    /// by value. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the vector container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::vector<T>& container)
+    {
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::VECTOR);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (const auto& item : container) 
+            {
+                ms.write(os, item, false);
+            }
+        }
+        return os;
+    }
+
+    /// Read into a vector container from a stream. Items in vector are stored 
+    /// by value. 
+    /// @param[in] is - the input stream
+    /// @param[in] container - the vector container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::vector<T>& container)
+    {
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::VECTOR))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    T t;
+                    ms.read(is, t, false);
+                    container.push_back(t);
+                }
+            }
+        }
+        return is;
+    }
+};
+
+/// Serialize a std::vector container. The items in vector are stored by pointer.
+template <class T>
+struct serialize_container<std::vector<T*>>
+{
+    static const bool supported = true;
+
+    /// Write a vector container to a stream. The items in vector are stored
+    /// by pointer. 
+    /// @param[in] os - the output stream
+    /// @param[in] container - the vector container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::vector<T*>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::VECTOR);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (auto* ptr : container) 
+            {
+                if (ptr != nullptr) 
+                {
+                    bool notNULL = true;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+
+                    auto* i = static_cast<serialize::I*>(ptr);
+                    ms.write(os, i);
+                }
+                else
+                {
+                    bool notNULL = false;
+                    ms.write_overhead(os, notNULL, serialize::WireBytes::NULL_FLAG);
+                }
+            }
+
+        }
+        return os;
+    }
+
+    /// Read into a vector container from a stream. Items in vector stored
+    /// by pointer. Operator new called to create object instances.
+    /// @param[in] is - the input stream
+    /// @param[in] container - the vector container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::vector<T*>& container)
+    {
+        static_assert(std::is_base_of<serialize::I, T>::value, "Type T must be derived from serialize::I");
+
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::VECTOR))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    bool notNULL = false;
+                    ms.read_overhead(is, notNULL, serialize::WireBytes::NULL_FLAG);
+
+                    if (notNULL)
+                    {
+                        if (!ms.charge_allocation(is))
+                            break;
+                        T *object = new T;
+                        auto *i = static_cast<serialize::I*>(object);
+                        ms.read(is, i);
+                        container.push_back(object);
+                    }
+                    else
+                    {
+                        container.push_back(nullptr);
+                    }
+                }
+            }
+        }
+        return is;
+    }
+};
+
+/// Serialize a std::vector<bool> container.
+template <>
+struct serialize_container<std::vector<bool>>
+{
+    static const bool supported = true;
+
+    /// Read a vector<bool> container from a stream. The vector<bool> items are 
+    /// stored differently and therefore need special handling to serialize. 
+    /// Unlike other specializations of vector, std::vector<bool> does not manage a
+    /// dynamic array of bool objects. Instead, it is supposed to pack the boolean 
+    /// values into a single bit each.
+    /// @param[in] is - the input stream
+    /// @param[in] container - the vector container to read into
+    /// @return The input stream
+    static std::istream& read(serialize& ms, std::istream& is, std::vector<bool>& container)
+    {
+        if (ms.check_stop_parse(is))
+            return is;
+
+        container.clear();
+        if (ms.read_type(is, serialize::Type::VECTOR))
+        {
+            uint16_t size = 0;
+            ms.read_overhead(is, size, serialize::WireBytes::LENGTH_PREFIX);
+            if (ms.check_stream(is) && ms.check_container_size(is, size) && ms.charge_elements(is, size))
+            {
+                ms.parseStatus(typeid(container), size);
+                serialize::element_scope scope(ms);
+                for (uint16_t i = 0; i < size; ++i)
+                {
+                    bool t;
+                    ms.read(is, t);
+                    container.push_back(t);
+                }
+            }
+        }
+        return is;
+    }
+
+    /// Write a vector<bool> container to a stream. The vector<bool> items are 
+    /// stored differently and therefore need special handling to serialize. 
+    /// Unlike other specialisations of vector, std::vector<bool> does not manage a 
+    /// dynamic array of bool objects.Instead, it is supposed to pack the boolean 
+    /// values into a single bit each.
+    /// @param[in] os - the output stream
+    /// @param[in] container - the vector container to write 
+    /// @return The output stream
+    static std::ostream& write(serialize& ms, std::ostream& os, std::vector<bool>& container)
+    {
+        uint16_t size = static_cast<uint16_t>(container.size());
+        ms.write_type(os, serialize::Type::VECTOR);
+        ms.write_overhead(os, size, serialize::WireBytes::LENGTH_PREFIX);
+        if (ms.check_stream(os) && ms.check_container_size(os, size))
+        {
+            serialize::element_scope scope(ms);
+            for (const bool& c : container) 
+            {
+                ms.write(os, c);
+            }
+        }
+        return os;
+    }
+};
+
+#endif // _SERIALIZE_VECTOR_H
@@ -0,0 +1,943 @@
+/// @file serialize_gen.cpp
+/// @see https://github.com/endurodave/MessageSerialize
+/// David Lafreniere, 2024.
+///
+/// Schema code generator. Reads message and enum definitions from an IDL file
+/// and writes a header of serialize::I classes with matching write() and read()
+/// functions, field layouts, field ids, fixed size traits and view accessors.
+///
+/// Usage: serialize_gen <input.idl> <output.h>
+///
+/// IDL example:
+///
+/// enum Status : uint8 { IDLE, ACTIVE, FAULT = 10 }
+///
+/// message Position
+/// {
+///     int32 latitude;
+///     int32 longitude;
+/// }
+///
+/// message Track
+/// {
+///     uint32 trackId;
+///     Status status;
+///     char callsign[16];
+///     string description;
+///     Position position;
+///     vector<Position> history;
+///     list<Position*> route;
+///     map<uint16, Position> waypoints;
+///     set<uint32> tags;
+/// }
+///
+/// Scalar types are bool, int8, uint8, int16, uint16, int32, uint32, int64,
+/// uint64, float and double. A type must be declared before it is used.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct scalar_info
+{
+    const char* idl;
+    const char* cpp;
+    const char* kind;
+    size_t size;
+};
+
+const scalar_info SCALARS[] = {
+    { "bool", "bool", "BOOL", 1 },
+    { "int8", "int8_t", "INT8", 1 },
+    { "uint8", "uint8_t", "UINT8", 1 },
+    { "int16", "int16_t", "INT16", 2 },
+    { "uint16", "uint16_t", "UINT16", 2 },
+    { "int32", "int32_t", "INT32", 4 },
+    { "uint32", "uint32_t", "UINT32", 4 },
+    { "int64", "int64_t", "INT64", 8 },
+    { "uint64", "uint64_t", "UINT64", 8 },
+    { "float", "float", "FLOAT", 4 },
+    { "double", "double", "DOUBLE", 8 },
+};
+
+const scalar_info* find_scalar(const std::string& name)
+{
+    for (const scalar_info& s : SCALARS)
+    {
+        if (name == s.idl)
+            return &s;
+    }
+    return nullptr;
+}
+
+enum class category { SCALAR, ENUM, STRING, WSTRING, CSTRING, MESSAGE, CONTAINER };
+
+/// A scalar, enum or message used as a field, container element or map key
+struct type_ref
+{
+    category cat = category::SCALAR;
+    std::string name;               // IDL type name
+    const scalar_info* scalar = nullptr;
+    bool pointer = false;
+};
+
+struct field_def
+{
+    std::string name;
+    type_ref type;
+    std::string container;          // VECTOR, LIST, SET or MAP
+    type_ref key;                   // MAP key
+    type_ref element;               // Container element or MAP value
+    size_t arraySize = 0;           // CSTRING size
+};
+
+struct enum_def
+{
+    std::string name;
+    const scalar_info* underlying = nullptr;
+    std::vector<std::pair<std::string, std::string>> values;
+};
+
+struct message_def
+{
+    std::string name;
+    std::vector<field_def> fields;
+    bool fixed = true;
+    size_t encodedSize = 0;
+    size_t untaggedSize = 0;
+    bool needsLess = false;
+    bool planned = true;
+};
+
+struct token
+{
+    std::string text;
+    int line;
+};
+
+class parser
+{
+public:
+    parser(const std::string& file_, const std::string& text) : file(file_)
+    {
+        tokenize(text);
+    }
+
+    bool parse()
+    {
+        while (ok && pos < tokens.size())
+        {
+            if (accept("enum"))
+                parse_enum();
+            else if (accept("message"))
+                parse_message();
+            else
+                error("expected 'enum' or 'message'");
+        }
+        return ok;
+    }
+
+    std::vector<enum_def> enums;
+    std::vector<message_def> messages;
+    std::vector<std::string> order;     // Declaration order of enums and messages
+
+private:
+    void tokenize(const std::string& text)
+    {
+        int line = 1;
+        size_t i = 0;
+        while (i < text.size())
+        {
+            char c = text[i];
+            if (c == '\n')
+            {
+                line++;
+                i++;
+            }
+            else if (isspace(static_cast<unsigned char>(c)))
+            {
+                i++;
+            }
+            else if (c == '/' && i + 1 < text.size() && text[i + 1] == '/')
+            {
+                while (i < text.size() && text[i] != '\n')
+                    i++;
+            }
+            else if (c == '/' && i + 1 < text.size() && text[i + 1] == '*')
+            {
+                i += 2;
+                while (i + 1 < text.size() && !(text[i] == '*' && text[i + 1] == '/'))
+                {
+                    if (text[i] == '\n')
+                        line++;
+                    i++;
+                }
+                i += 2;
+            }
+            else if (isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-')
+            {
+                size_t start = i++;
+                while (i < text.size() && (isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_'))
+                    i++;
+                tokens.push_back(token{ text.substr(start, i - start), line });
+            }
+            else
+            {
+                tokens.push_back(token{ std::string(1, c), line });
+                i++;
+            }
+        }
+    }
+
+    const std::string& peek() const
+    {
+        static const std::string end;
+        return pos < tokens.size() ? tokens[pos].text : end;
+    }
+
+    bool accept(const char* text)
+    {
+        if (peek() == text)
+        {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char* text)
+    {
+        if (!accept(text))
+            error(std::string("expected '") + text + "'");
+    }
+
+    std::string identifier()
+    {
+        const std::string& t = peek();
+        if (t.empty() || !(isalpha(static_cast<unsigned char>(t[0])) || t[0] == '_'))
+        {
+            error("expected an identifier");
+            return std::string();
+        }
+        pos++;
+        return t;
+    }
+
+    /// Read the name of a declared enum, enum value, message or field. It
+    /// becomes a C++ identifier, so keywords are rejected.
+    std::string declared_identifier()
+    {
+        static const char* keywords[] = { "alignas", "alignof", "and", "and_eq", "asm", "auto",
+            "bitand", "bitor", "bool", "break", "case", "catch", "char", "char8_t", "char16_t",
+            "char32_t", "class", "co_await", "co_return", "co_yield", "compl", "concept", "const",
+            "consteval", "constexpr", "constinit", "const_cast", "continue", "decltype", "default",
+            "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern",
+            "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+            "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq",
+            "private", "protected", "public", "register", "reinterpret_cast", "requires", "return",
+            "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+            "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+            "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+            "wchar_t", "while", "xor", "xor_eq" };
+        std::string name = identifier();
+        for (const char* k : keywords)
+        {
+            if (name == k)
+            {
+                pos--;
+                error("'" + name + "' is a C++ keyword");
+                return std::string();
+            }
+        }
+        return name;
+    }
+
+    std::string number()
+    {
+        const std::string& t = peek();
+        char* end = nullptr;
+        strtoll(t.c_str(), &end, 0);
+        if (t.empty() || *end != '\0')
+        {
+            error("expected a number");
+            return std::string();
+        }
+        pos++;
+        return t;
+    }
+
+    void error(const std::string& message)
+    {
+        if (ok)
+        {
+            int line = pos < tokens.size() ? tokens[pos].line : (tokens.empty() ? 1 : tokens.back().line);
+            std::cerr << file << ":" << line << ": error: " << message << std::endl;
+        }
+        ok = false;
+        pos = tokens.size();
+    }
+
+    void declare(const std::string& name)
+    {
+        if (find_scalar(name) || name == "string" || name == "wstring" || name == "char" || declared.count(name))
+            error("'" + name + "' is already defined");
+        declared.insert(name);
+        order.push_back(name);
+    }
+
+    void parse_enum()
+    {
+        enum_def e;
+        e.name = declared_identifier();
+        expect(":");
+        e.underlying = find_scalar(identifier());
+        if (!ok)
+            return;
+        if (!e.underlying || e.underlying->kind == std::string("BOOL") ||
+            e.underlying->kind == std::string("FLOAT") || e.underlying->kind == std::string("DOUBLE"))
+        {
+            pos--;
+            error("enum underlying type must be an integer");
+            return;
+        }
+        declare(e.name);
+        expect("{");
+        while (ok && !accept("}"))
+        {
+            std::string name = declared_identifier();
+            std::string value;
+            if (accept("="))
+                value = number();
+            e.values.push_back(std::make_pair(name, value));
+            if (!accept(","))
+            {
+                expect("}");
+                break;
+            }
+        }
+        enums.push_back(e);
+    }
+
+    type_ref parse_type_ref()
+    {
+        type_ref t;
+        t.name = identifier();
+        if (!ok)
+            return t;
+        t.scalar = find_scalar(t.name);
+        if (t.scalar)
+            t.cat = category::SCALAR;
+        else if (find_enum(t.name))
+            t.cat = category::ENUM;
+        else if (find_message(t.name))
+            t.cat = category::MESSAGE;
+        else
+        {
+            pos--;
+            error("unknown type '" + t.name + "'");
+        }
+        return t;
+    }
+
+    void parse_message()
+    {
+        message_def m;
+        m.name = declared_identifier();
+        declare(m.name);
+        expect("{");
+        while (ok && !accept("}"))
+        {
+            field_def f;
+            const std::string typeName = peek();
+            if (accept("string"))
+                f.type.cat = category::STRING;
+            else if (accept("wstring"))
+                f.type.cat = category::WSTRING;
+            else if (accept("char"))
+                f.type.cat = category::CSTRING;
+            else if (typeName == "vector" || typeName == "list" || typeName == "set" || typeName == "map")
+            {
+                pos++;
+                f.type.cat = category::CONTAINER;
+                f.container = typeName == "vector" ? "VECTOR" : typeName == "list" ? "LIST" : typeName == "set" ? "SET" : "MAP";
+                expect("<");
+                if (f.container == "MAP")
+                {
+                    f.key = parse_type_ref();
+                    if (ok && f.key.cat == category::MESSAGE)
+                        error("map key must be a scalar or enum");
+                    expect(",");
+                }
+                f.element = parse_type_ref();
+                if (ok && accept("*"))
+                {
+                    if (f.element.cat != category::MESSAGE)
+                        error("only message elements may be pointers");
+                    f.element.pointer = true;
+                }
+                expect(">");
+            }
+            else
+            {
+                f.type = parse_type_ref();
+            }
+
+            f.name = declared_identifier();
+            if (f.type.cat == category::CSTRING)
+            {
+                expect("[");
+                std::string size = number();
+                f.arraySize = static_cast<size_t>(strtoull(size.c_str(), nullptr, 0));
+                if (ok && (f.arraySize == 0 || f.arraySize > 256))
+                    error("char array size must be 1 to 256");
+                expect("]");
+            }
+            expect(";");
+
+            // Names used by the generated class, and the parameters and locals
+            // of its member functions, which would hide the field
+            static const char* reserved[] = { "field", "view", "write", "read", "fieldOffset",
+                "FIELD_COUNT", "FIXED_SIZE", "ENCODED_SIZE", "UNTAGGED_SIZE",
+                "ms", "os", "is", "other", "ptr", "data", "valid" };
+            for (const char* r : reserved)
+            {
+                if (f.name == r)
+                    error("field name '" + f.name + "' is reserved");
+            }
+            for (const field_def& other : m.fields)
+            {
+                if (other.name == f.name)
+                    error("duplicate field '" + f.name + "'");
+            }
+            m.fields.push_back(f);
+        }
+        messages.push_back(m);
+    }
+
+public:
+    const enum_def* find_enum(const std::string& name) const
+    {
+        for (const enum_def& e : enums)
+        {
+            if (e.name == name)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    message_def* find_message(const std::string& name)
+    {
+        for (message_def& m : messages)
+        {
+            if (m.name == name)
+                return &m;
+        }
+        return nullptr;
+    }
+
+private:
+    std::string file;
+    std::vector<token> tokens;
+    size_t pos = 0;
+    bool ok = true;
+    std::set<std::string> declared;
+};
+
+class generator
+{
+public:
+    generator(parser& p_, const std::string& input_, const std::string& output_) :
+        p(p_), input(input_), output(output_) {}
+
+    bool generate(std::ostream& os)
+    {
+        compute_sizes();
+        compute_plans();
+        if (!mark_less())
+            return false;
+
+        std::string base = output.substr(output.find_last_of("/\\") + 1);
+        std::string guard = "_";
+        for (char c : base)
+            guard += isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(toupper(static_cast<unsigned char>(c))) : '_';
+
+        os << "/// @file " << base << "\n";
+        os << "/// Generated by serialize_gen from " << input.substr(input.find_last_of("/\\") + 1) << ". Do not edit.\n\n";
+        os << "#ifndef " << guard << "\n";
+        os << "#define " << guard << "\n\n";
+        includes(os);
+
+        for (const std::string& name : p.order)
+        {
+            if (const enum_def* e = p.find_enum(name))
+                emit_enum(os, *e);
+            else
+                emit_message(os, *p.find_message(name));
+        }
+
+        os << "#endif // " << guard << "\n";
+        return true;
+    }
+
+private:
+    static std::string cpp_type(const type_ref& t)
+    {
+        if (t.cat == category::SCALAR)
+            return t.scalar->cpp;
+        return t.name + (t.pointer ? "*" : "");
+    }
+
+    std::string kind_of(const type_ref& t) const
+    {
+        if (t.cat == category::SCALAR)
+            return std::string("field_kind::") + t.scalar->kind;
+        if (t.cat == category::ENUM)
+            return "field_kind_of<" + t.name + ">::value";
+        return t.pointer ? "field_kind::OBJECT_PTR" : "field_kind::OBJECT";
+    }
+
+    size_t scalar_size(const type_ref& t) const
+    {
+        if (t.cat == category::ENUM)
+            return p.find_enum(t.name)->underlying->size;
+        return t.scalar->size;
+    }
+
+    /// Fixed encoded sizes. A message is fixed if every field is a scalar,
+    /// an enum or a fixed size message.
+    void compute_sizes()
+    {
+        for (message_def& m : p.messages)
+        {
+            // USER_DEFINED type and size
+            m.encodedSize = m.untaggedSize = 3;
+            for (const field_def& f : m.fields)
+            {
+                if (f.type.cat == category::SCALAR || f.type.cat == category::ENUM)
+                {
+                    m.encodedSize += 1 + scalar_size(f.type);
+                    m.untaggedSize += scalar_size(f.type);
+                }
+                else if (f.type.cat == category::MESSAGE && p.find_message(f.type.name)->fixed)
+                {
+                    m.encodedSize += p.find_message(f.type.name)->encodedSize;
+                    m.untaggedSize += p.find_message(f.type.name)->untaggedSize;
+                }
+                else
+                {
+                    m.fixed = false;
+                }
+            }
+            if (!m.fixed || m.encodedSize > 0xFFFF)
+            {
+                m.fixed = false;
+                m.encodedSize = m.untaggedSize = 0;
+            }
+        }
+    }
+
+    /// A message gets a decode plan if every field is a scalar, an enum, a
+    /// string, a char array or a message with a decode plan.
+    void compute_plans()
+    {
+        for (message_def& m : p.messages)
+        {
+            for (const field_def& f : m.fields)
+            {
+                if (f.type.cat == category::WSTRING || f.type.cat == category::CONTAINER ||
+                    (f.type.cat == category::MESSAGE && !p.find_message(f.type.name)->planned))
+                    m.planned = false;
+            }
+        }
+    }
+
+    /// Messages stored by value in a set need operator<
+    bool mark_less()
+    {
+        for (message_def& m : p.messages)
+        {
+            for (const field_def& f : m.fields)
+            {
+                if (f.container == "SET" && f.element.cat == category::MESSAGE && !f.element.pointer)
+                {
+                    if (!mark_less(*p.find_message(f.element.name)))
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool mark_less(message_def& m)
+    {
+        m.needsLess = true;
+        for (const field_def& f : m.fields)
+        {
+            if (f.type.cat == category::MESSAGE)
+            {
+                if (!mark_less(*p.find_message(f.type.name)))
+                    return false;
+            }
+            else if (f.type.cat == category::CSTRING || f.type.cat == category::CONTAINER)
+            {
+                std::cerr << input << ": error: message '" << m.name << "' is a set element so field '"
+                    << f.name << "' must be a scalar, enum, string or message" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void includes(std::ostream& os)
+    {
+        std::set<std::string> containers;
+        bool strings = false, less = false, plans = false;
+        for (const message_def& m : p.messages)
+        {
+            less = less || m.needsLess;
+            plans = plans || m.planned;
+            for (const field_def& f : m.fields)
+            {
+                if (f.type.cat == category::CONTAINER)
+                    containers.insert(f.container);
+                strings = strings || f.type.cat == category::STRING || f.type.cat == category::WSTRING;
+            }
+        }
+
+        os << "#include \"serialize_core.h\"\n";
+        const char* headers[][2] = { { "VECTOR", "vector" }, { "LIST", "list" }, { "MAP", "map" }, { "SET", "set" } };
+        for (const auto& h : headers)
+        {
+            if (containers.count(h[0]))
+                os << "#include \"serialize_" << h[1] << ".h\"\n";
+        }
+        os << "#include \"serialize_layout.h\"\n";
+        if (plans)
+            os << "#include \"serialize_plan.h\"\n";
+        if (strings)
+            os << "#include <string>\n";
+        if (less)
+            os << "#include <tuple>\n";
+        os << "\n";
+    }
+
+    void emit_enum(std::ostream& os, const enum_def& e)
+    {
+        os << "enum class " << e.name << " : " << e.underlying->cpp << "\n{\n";
+        for (size_t i = 0; i < e.values.size(); i++)
+        {
+            os << "    " << e.values[i].first;
+            if (!e.values[i].second.empty())
+                os << " = " << e.values[i].second;
+            os << (i + 1 < e.values.size() ? ",\n" : "\n");
+        }
+        os << "};\n\n";
+    }
+
+    void emit_message(std::ostream& os, const message_def& m)
+    {
+        bool pointers = false;
+        for (const field_def& f : m.fields)
+            pointers = pointers || f.element.pointer;
+
+        os << "class " << m.name << " : public serialize::I\n{\npublic:\n";
+
+        os << "    /// Field ids in encoded order\n";
+        os << "    enum class field : uint16_t\n    {\n";
+        for (size_t i = 0; i < m.fields.size(); i++)
+            os << "        " << m.fields[i].name << (i + 1 < m.fields.size() ? ",\n" : "\n");
+        os << "    };\n";
+        os << "    static const uint16_t FIELD_COUNT = " << m.fields.size() << ";\n\n";
+
+        os << "    /// True if every field has a fixed encoded size\n";
+        os << "    static const bool FIXED_SIZE = " << (m.fixed ? "true" : "false") << ";\n\n";
+        os << "    /// Tagged and untagged encoded sizes if FIXED_SIZE, otherwise 0\n";
+        os << "    static const uint16_t ENCODED_SIZE = " << m.encodedSize << ";\n";
+        os << "    static const uint16_t UNTAGGED_SIZE = " << m.untaggedSize << ";\n\n";
+
+        os << "    " << m.name << "() = default;\n";
+        if (pointers)
+        {
+            os << "    virtual ~" << m.name << "()\n    {\n";
+            for (const field_def& f : m.fields)
+            {
+                if (!f.element.pointer)
+                    continue;
+                os << "        for (auto& ptr : " << f.name << ")\n";
+                os << "            delete ptr" << (f.container == "MAP" ? ".second" : "") << ";\n";
+            }
+            os << "    }\n\n";
+            os << "    " << m.name << "(const " << m.name << "&) = delete;\n";
+            os << "    " << m.name << "& operator=(const " << m.name << "&) = delete;\n\n";
+        }
+        else
+        {
+            os << "    virtual ~" << m.name << "() = default;\n\n";
+        }
+
+        os << "    virtual std::ostream& write(serialize& ms, std::ostream& os) override\n    {\n";
+        for (const field_def& f : m.fields)
+            os << "        ms.write(os, " << f.name << ");\n";
+        os << "        return os;\n    }\n\n";
+
+        os << "    virtual std::istream& read(serialize& ms, std::istream& is) override\n    {\n";
+        for (const field_def& f : m.fields)
+        {
+            // A char array read is bounded by its size
+            if (f.type.cat == category::CSTRING)
+                os << "        ms.read(is, " << f.name << ", sizeof(" << f.name << "));\n";
+            else
+                os << "        ms.read(is, " << f.name << ");\n";
+        }
+        os << "        return is;\n    }\n\n";
+
+        if (m.needsLess)
+        {
+            os << "    bool operator<(const " << m.name << "& other) const\n    {\n";
+            os << "        return std::tie(";
+            for (size_t i = 0; i < m.fields.size(); i++)
+                os << (i ? ", " : "") << m.fields[i].name;
+            os << ") <\n            std::tie(";
+            for (size_t i = 0; i < m.fields.size(); i++)
+                os << (i ? ", " : "") << "other." << m.fields[i].name;
+            os << ");\n    }\n\n";
+        }
+
+        if (m.fixed)
+            emit_view(os, m);
+
+        for (const field_def& f : m.fields)
+        {
+            switch (f.type.cat)
+            {
+            case category::SCALAR:
+                os << "    " << cpp_type(f.type) << " " << f.name << (f.type.name == "bool" ? " = false;\n" : " = 0;\n");
+                break;
+            case category::ENUM:
+                os << "    " << cpp_type(f.type) << " " << f.name << " = " << cpp_type(f.type) << "();\n";
+                break;
+            case category::STRING:
+                os << "    std::string " << f.name << ";\n";
+                break;
+            case category::WSTRING:
+                os << "    std::wstring " << f.name << ";\n";
+                break;
+            case category::CSTRING:
+                os << "    char " << f.name << "[" << f.arraySize << "] = { 0 };\n";
+                break;
+            case category::MESSAGE:
+                os << "    " << f.type.name << " " << f.name << ";\n";
+                break;
+            case category::CONTAINER:
+                if (f.container == "MAP")
+                    os << "    std::map<" << cpp_type(f.key) << ", " << cpp_type(f.element) << "> " << f.name << ";\n";
+                else
+                    os << "    std::" << (f.container == "VECTOR" ? "vector" : f.container == "LIST" ? "list" : "set")
+                        << "<" << cpp_type(f.element) << "> " << f.name << ";\n";
+                break;
+            }
+        }
+        os << "};\n\n";
+
+        emit_layout(os, m);
+        if (m.planned)
+            emit_plan(os, m);
+    }
+
+    /// Fixed size messages get field offsets and a view over the encoded bytes
+    void emit_view(std::ostream& os, const message_def& m)
+    {
+        // Offset of each field's value within the tagged encoding
+        std::vector<size_t> offsets;
+        size_t offset = 3;
+        for (const field_def& f : m.fields)
+        {
+            if (f.type.cat == category::MESSAGE)
+            {
+                offsets.push_back(offset);
+                offset += p.find_message(f.type.name)->encodedSize;
+            }
+            else
+            {
+                offsets.push_back(offset + 1);
+                offset += 1 + scalar_size(f.type);
+            }
+        }
+
+        os << "    /// Offset of a field within the tagged encoding. A scalar offset is the\n";
+        os << "    /// value after its type byte. A message offset is the start of its encoding.\n";
+        os << "    static constexpr size_t fieldOffset(field f)\n    {\n";
+        os << "        switch (f)\n        {\n";
+        for (size_t i = 0; i < m.fields.size(); i++)
+            os << "        case field::" << m.fields[i].name << ": return " << offsets[i] << ";\n";
+        os << "        }\n        return 0;\n    }\n\n";
+
+        os << "    /// @brief Reads fields directly from a tagged encoding without decoding.\n";
+        os << "    class view\n    {\n    public:\n";
+        os << "        explicit view(const char* data_) : data(data_) {}\n\n";
+        os << "        /// Returns true if the bytes are a tagged encoding of exactly this message\n";
+        os << "        /// version. Otherwise decode the message normally.\n";
+        os << "        static bool valid(const char* data, size_t size)\n        {\n";
+        os << "            if (size != ENCODED_SIZE || static_cast<uint8_t>(data[0]) != static_cast<uint8_t>(serialize::Type::USER_DEFINED) ||\n";
+        os << "                wire_load<uint16_t>(data + 1) != ENCODED_SIZE - 1)\n";
+        os << "                return false;\n";
+        for (size_t i = 0; i < m.fields.size(); i++)
+        {
+            const field_def& f = m.fields[i];
+            if (f.type.cat == category::MESSAGE)
+                os << "            if (!" << f.type.name << "::view::valid(data + " << offsets[i] << ", "
+                    << f.type.name << "::ENCODED_SIZE))\n";
+            else
+                os << "            if (static_cast<uint8_t>(data[" << offsets[i] - 1 << "]) != static_cast<uint8_t>(serialize::Type::LITERAL))\n";
+            os << "                return false;\n";
+        }
+        os << "            return true;\n        }\n\n";
+
+        for (size_t i = 0; i < m.fields.size(); i++)
+        {
+            const field_def& f = m.fields[i];
+            if (f.type.cat == category::MESSAGE)
+                os << "        " << f.type.name << "::view " << f.name << "() const { return " << f.type.name
+                    << "::view(data + " << offsets[i] << "); }\n";
+            else
+                os << "        " << cpp_type(f.type) << " " << f.name << "() const { return wire_load<"
+                    << cpp_type(f.type) << ">(data + " << offsets[i] << "); }\n";
+        }
+        os << "\n    private:\n        const char* data;\n    };\n\n";
+    }
+
+    void emit_layout(std::ostream& os, const message_def& m)
+    {
+        os << "static constexpr field_desc " << m.name << "Fields[] = {\n";
+        for (size_t i = 0; i < m.fields.size(); i++)
+        {
+            const field_def& f = m.fields[i];
+            os << "    ";
+            switch (f.type.cat)
+            {
+            case category::SCALAR:
+            case category::ENUM:
+                os << "layout_field(\"" << f.name << "\", " << kind_of(f.type) << ")";
+                break;
+            case category::STRING:
+                os << "layout_field(\"" << f.name << "\", field_kind::STRING)";
+                break;
+            case category::WSTRING:
+                os << "layout_field(\"" << f.name << "\", field_kind::WSTRING)";
+                break;
+            case category::CSTRING:
+                os << "layout_field(\"" << f.name << "\", field_kind::CSTRING)";
+                break;
+            case category::MESSAGE:
+                os << "layout_object(\"" << f.name << "\", " << f.type.name << "Layout)";
+                break;
+            case category::CONTAINER:
+                if (f.container == "MAP")
+                    os << "layout_map(\"" << f.name << "\", " << kind_of(f.key) << ", " << kind_of(f.element);
+                else
+                    os << "layout_container(\"" << f.name << "\", field_kind::" << f.container << ", " << kind_of(f.element);
+                if (f.element.cat == category::MESSAGE)
+                    os << ", " << f.element.name << "Layout";
+                os << ")";
+                break;
+            }
+            os << (i + 1 < m.fields.size() ? ",\n" : "\n");
+        }
+        os << "};\n";
+        os << "static constexpr type_layout " << m.name << "Layout = make_layout(\"" << m.name << "\", "
+            << m.name << "Fields);\n\n";
+    }
+
+    /// Bind the layout to the class members and build the decode plan on first use
+    void emit_plan(std::ostream& os, const message_def& m)
+    {
+        bool objects = false;
+        for (const field_def& f : m.fields)
+            objects = objects || f.type.cat == category::MESSAGE;
+
+        os << "static inline const type_binding& " << m.name << "Binding()\n{\n";
+        os << "    static const " << m.name << " instance;\n";
+        if (!m.fields.empty())
+        {
+            os << "    static const size_t offsets[] = {\n";
+            for (size_t i = 0; i < m.fields.size(); i++)
+                os << "        member_offset(instance, instance." << m.fields[i].name << ")"
+                    << (i + 1 < m.fields.size() ? ",\n" : "\n");
+            os << "    };\n";
+            os << "    static const size_t sizes[] = {\n";
+            for (size_t i = 0; i < m.fields.size(); i++)
+                os << "        sizeof(instance." << m.fields[i].name << ")" << (i + 1 < m.fields.size() ? ",\n" : "\n");
+            os << "    };\n";
+        }
+        if (objects)
+        {
+            os << "    static const type_binding* const objects[] = {\n";
+            for (size_t i = 0; i < m.fields.size(); i++)
+            {
+                const field_def& f = m.fields[i];
+                os << "        " << (f.type.cat == category::MESSAGE ? "&" + f.type.name + "Binding()" : "nullptr")
+                    << (i + 1 < m.fields.size() ? ",\n" : "\n");
+            }
+            os << "    };\n";
+        }
+        os << "    static const type_binding binding = { &typeid(" << m.name << "), &" << m.name << "Layout, "
+            << (m.fields.empty() ? "nullptr, nullptr, " : "offsets, sizes, ") << (objects ? "objects" : "nullptr") << " };\n";
+        os << "    return binding;\n}\n\n";
+
+        os << "static inline const decode_plan& " << m.name << "Plan()\n{\n";
+        os << "    static const decode_plan plan(" << m.name << "Binding());\n";
+        os << "    return plan;\n}\n\n";
+    }
+
+    parser& p;
+    std::string input;
+    std::string output;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: serialize_gen <input.idl> <output.h>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::in | std::ios::binary);
+    if (!in)
+    {
+        std::cerr << argv[1] << ": error: cannot open file" << std::endl;
+        return 1;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    parser p(argv[1], text.str());
+    if (!p.parse())
+        return 1;
+
+    // Generate to memory so a failed run leaves no partial output
+    std::stringstream out;
+    generator g(p, argv[1], argv[2]);
+    if (!g.generate(out))
+        return 1;
+
+    std::ofstream file(argv[2], std::ios::out | std::ios::binary);
+    file << out.str();
+    if (!file)
+    {
+        std::cerr << argv[2] << ": error: cannot write file" << std::endl;
+        return 1;
+    }
+    return 0;
+}